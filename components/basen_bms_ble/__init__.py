@@ -1,36 +1,329 @@
+from esphome import automation
 import esphome.codegen as cg
-from esphome.components import ble_client
+from esphome.components import ble_client, deep_sleep
 import esphome.config_validation as cv
-from esphome.const import CONF_ID
+from esphome.const import CONF_ADDRESS, CONF_ID, CONF_TRIGGER_ID
+from esphome.core import TimePeriod
+import esphome.final_validate as fv
 
 CODEOWNERS = ["@syssi"]
 
 AUTO_LOAD = ["binary_sensor", "sensor", "switch", "text_sensor"]
 MULTI_CONF = True
+# Auto loaded by basen_bms_uart for the protocol core and the entity platforms: don't create a BLE hub then
+MULTI_CONF_NO_DEFAULT = True
 
 CONF_BASEN_BMS_BLE_ID = "basen_bms_ble_id"
 CONF_ENABLE_FAKE_TRAFFIC = "enable_fake_traffic"
+CONF_EXPERIMENTAL_BALANCING_BITMAP = "experimental_balancing_bitmap"
+CONF_CELL_STATISTICS_WINDOW = "cell_statistics_window"
+CONF_CELL_STATISTICS_SMOOTHING = "cell_statistics_smoothing"
+CONF_INTERNAL_RESISTANCE_CURRENT_STEP = "internal_resistance_current_step"
+CONF_ADAPTIVE_POLLING = "adaptive_polling"
+CONF_MIN_UPDATE_INTERVAL = "min_update_interval"
+CONF_MAX_UPDATE_INTERVAL = "max_update_interval"
+CONF_CURRENT_THRESHOLD = "current_threshold"
+CONF_VOLTAGE_RATE_THRESHOLD = "voltage_rate_threshold"
+CONF_PACKS = "packs"
+CONF_HISTORY_SIZE = "history_size"
+CONF_LOW_POWER = "low_power"
+CONF_DEEP_SLEEP_ID = "deep_sleep_id"
+CONF_SLEEP_DELAY = "sleep_delay"
+CONF_THRESHOLD = "threshold"
+CONF_HYSTERESIS = "hysteresis"
+
+CONF_ON_CELL_OVERVOLTAGE = "on_cell_overvoltage"
+CONF_ON_CELL_UNDERVOLTAGE = "on_cell_undervoltage"
+CONF_ON_OVERTEMPERATURE = "on_overtemperature"
+CONF_ON_DELTA_EXCEEDED = "on_delta_exceeded"
+CONF_ON_WARNING_RAISED = "on_warning_raised"
+
+DEFAULT_ADDRESS = 0x16
+
+FRAME_TYPE_CELL_VOLTAGES_1_12 = 0x24
+FRAME_TYPE_CELL_VOLTAGES_13_24 = 0x25
+FRAME_TYPE_CELL_VOLTAGES_25_34 = 0x26
+FRAME_TYPE_STATUS = 0x2A
+FRAME_TYPE_GENERAL_INFO = 0x2B
+FRAME_TYPE_BALANCING = 0xFE
+
+FRAME_TYPES_CELL_VOLTAGES = [
+    FRAME_TYPE_CELL_VOLTAGES_1_12,
+    FRAME_TYPE_CELL_VOLTAGES_13_24,
+    FRAME_TYPE_CELL_VOLTAGES_25_34,
+]
 
 basen_bms_ble_ns = cg.esphome_ns.namespace("basen_bms_ble")
+BasenBms = basen_bms_ble_ns.class_("BasenBms", cg.PollingComponent)
 BasenBmsBle = basen_bms_ble_ns.class_(
-    "BasenBmsBle", ble_client.BLEClientNode, cg.PollingComponent
+    "BasenBmsBle", BasenBms, ble_client.BLEClientNode
+)
+
+CellOvervoltageTrigger = basen_bms_ble_ns.class_(
+    "CellOvervoltageTrigger", automation.Trigger.template(cg.uint8, cg.float_)
+)
+CellUndervoltageTrigger = basen_bms_ble_ns.class_(
+    "CellUndervoltageTrigger", automation.Trigger.template(cg.uint8, cg.float_)
 )
+OvertemperatureTrigger = basen_bms_ble_ns.class_(
+    "OvertemperatureTrigger", automation.Trigger.template(cg.uint8, cg.float_)
+)
+DeltaExceededTrigger = basen_bms_ble_ns.class_(
+    "DeltaExceededTrigger", automation.Trigger.template(cg.float_)
+)
+WarningRaisedTrigger = basen_bms_ble_ns.class_(
+    "WarningRaisedTrigger", automation.Trigger.template(cg.std_string)
+)
+
+
+def threshold_automation(trigger_class, validator, hysteresis):
+    return automation.validate_automation(
+        {
+            cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(trigger_class),
+            cv.Required(CONF_THRESHOLD): validator,
+            cv.Optional(CONF_HYSTERESIS, default=hysteresis): cv.All(
+                validator, cv.positive_float
+            ),
+        }
+    )
+
+
+def validate_adaptive_polling(config):
+    if config[CONF_MIN_UPDATE_INTERVAL] > config[CONF_MAX_UPDATE_INTERVAL]:
+        raise cv.Invalid(
+            f"{CONF_MIN_UPDATE_INTERVAL} must not be greater than "
+            f"{CONF_MAX_UPDATE_INTERVAL}"
+        )
+    return config
 
-CONFIG_SCHEMA = (
+
+ADAPTIVE_POLLING_SCHEMA = cv.All(
     cv.Schema(
+        {
+            cv.Optional(
+                CONF_MIN_UPDATE_INTERVAL, default="2s"
+            ): cv.positive_time_period_milliseconds,
+            cv.Optional(
+                CONF_MAX_UPDATE_INTERVAL, default="60s"
+            ): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_CURRENT_THRESHOLD, default="1A"): cv.All(
+                cv.current, cv.positive_float
+            ),
+            # Change of the total voltage in V/s
+            cv.Optional(CONF_VOLTAGE_RATE_THRESHOLD, default=0.001): cv.positive_float,
+        }
+    ),
+    validate_adaptive_polling,
+)
+
+# Trigger arguments and the frames required to evaluate the trigger
+THRESHOLD_TRIGGERS = {
+    CONF_ON_CELL_OVERVOLTAGE: (
+        [(cg.uint8, "cell"), (cg.float_, "voltage")],
+        [FRAME_TYPE_CELL_VOLTAGES_1_12, FRAME_TYPE_CELL_VOLTAGES_13_24],
+    ),
+    CONF_ON_CELL_UNDERVOLTAGE: (
+        [(cg.uint8, "cell"), (cg.float_, "voltage")],
+        [FRAME_TYPE_CELL_VOLTAGES_1_12, FRAME_TYPE_CELL_VOLTAGES_13_24],
+    ),
+    CONF_ON_OVERTEMPERATURE: (
+        [(cg.uint8, "sensor"), (cg.float_, "temperature")],
+        [FRAME_TYPE_STATUS],
+    ),
+    CONF_ON_DELTA_EXCEEDED: (
+        [(cg.float_, "delta")],
+        [FRAME_TYPE_CELL_VOLTAGES_1_12, FRAME_TYPE_CELL_VOLTAGES_13_24],
+    ),
+}
+
+# Options of the protocol core shared by all transports
+BASEN_BMS_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_ADDRESS, default=DEFAULT_ADDRESS): cv.hex_uint8_t,
+        cv.Optional(CONF_ENABLE_FAKE_TRAFFIC, default=False): cv.boolean,
+        # Decodes bytes 13-17 of the balancing frame as cell bitmap (unconfirmed offset)
+        cv.Optional(CONF_EXPERIMENTAL_BALANCING_BITMAP, default=False): cv.boolean,
+        # Split into 6 buckets, a bucket should span several poll cycles
+        cv.Optional(CONF_CELL_STATISTICS_WINDOW, default="1h"): cv.All(
+            cv.positive_time_period_milliseconds,
+            cv.Range(min=TimePeriod(minutes=1)),
+        ),
+        # Weight of a new sample in the exponential moving average of each cell voltage
+        cv.Optional(CONF_CELL_STATISTICS_SMOOTHING, default=0.2): cv.float_range(
+            min=0.01, max=1.0
+        ),
+        cv.Optional(
+            CONF_INTERNAL_RESISTANCE_CURRENT_STEP, default="3A"
+        ): cv.All(cv.current, cv.positive_float),
+        cv.Optional(CONF_ADAPTIVE_POLLING): ADAPTIVE_POLLING_SCHEMA,
+        # Size of the compressed history ring in bytes (two blocks of 1 kB at least)
+        cv.Optional(CONF_HISTORY_SIZE): cv.int_range(min=2048, max=8388608),
+        cv.Optional(CONF_ON_CELL_OVERVOLTAGE): threshold_automation(
+            CellOvervoltageTrigger, cv.voltage, "0.02V"
+        ),
+        cv.Optional(CONF_ON_CELL_UNDERVOLTAGE): threshold_automation(
+            CellUndervoltageTrigger, cv.voltage, "0.02V"
+        ),
+        cv.Optional(CONF_ON_OVERTEMPERATURE): threshold_automation(
+            OvertemperatureTrigger, cv.temperature, "2°C"
+        ),
+        cv.Optional(CONF_ON_DELTA_EXCEEDED): threshold_automation(
+            DeltaExceededTrigger, cv.voltage, "0.005V"
+        ),
+        cv.Optional(CONF_ON_WARNING_RAISED): automation.validate_automation(
+            {
+                cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(WarningRaisedTrigger),
+            }
+        ),
+    }
+)
+
+
+def validate_pack_addresses(config):
+    addresses = [config[CONF_ADDRESS]]
+    for pack in config.get(CONF_PACKS, []):
+        if pack[CONF_ADDRESS] in addresses:
+            raise cv.Invalid(
+                f"Address 0x{pack[CONF_ADDRESS]:02X} is used by more than one pack"
+            )
+        addresses.append(pack[CONF_ADDRESS])
+    return config
+
+
+# Paralleled packs polled over the link of the hub and demultiplexed by address
+BASEN_BMS_PACK_SCHEMA = BASEN_BMS_SCHEMA.extend(
+    {
+        cv.GenerateID(): cv.declare_id(BasenBms),
+    }
+).extend(cv.polling_component_schema("10s"))
+
+BASEN_BMS_LINK_SCHEMA = BASEN_BMS_SCHEMA.extend(
+    {
+        cv.Optional(CONF_PACKS): cv.ensure_list(BASEN_BMS_PACK_SCHEMA),
+    }
+)
+
+CONFIG_SCHEMA = cv.All(
+    BASEN_BMS_LINK_SCHEMA.extend(
         {
             cv.GenerateID(): cv.declare_id(BasenBmsBle),
-            cv.Optional(CONF_ENABLE_FAKE_TRAFFIC, default=False): cv.boolean,
+            cv.Optional(CONF_LOW_POWER): cv.Schema(
+                {
+                    cv.GenerateID(CONF_DEEP_SLEEP_ID): cv.use_id(
+                        deep_sleep.DeepSleepComponent
+                    ),
+                    cv.Optional(
+                        CONF_SLEEP_DELAY, default="500ms"
+                    ): cv.positive_time_period_milliseconds,
+                }
+            ),
         }
     )
     .extend(ble_client.BLE_CLIENT_SCHEMA)
-    .extend(cv.polling_component_schema("10s"))
+    .extend(cv.polling_component_schema("10s")),
+    validate_pack_addresses,
 )
 
 
 async def to_code(config):
+    cg.add_define("USE_BASEN_BMS_BLE")
     var = cg.new_Pvariable(config[CONF_ID])
-    await cg.register_component(var, config)
+    await register_basen_bms(var, config)
     await ble_client.register_ble_node(var, config)
 
+    if CONF_LOW_POWER in config:
+        conf = config[CONF_LOW_POWER]
+        # Compiles the mode in, it is enabled per instance by the deep sleep component
+        cg.add_define("USE_BASEN_BMS_BLE_LOW_POWER")
+        deep_sleep_ = await cg.get_variable(conf[CONF_DEEP_SLEEP_ID])
+        cg.add(var.set_deep_sleep(deep_sleep_))
+        cg.add(var.set_sleep_delay(conf[CONF_SLEEP_DELAY]))
+
+
+async def register_basen_bms(var, config):
+    """Register the protocol core options and automations of a transport."""
+    await cg.register_component(var, config)
+
+    cg.add(var.set_address(config[CONF_ADDRESS]))
+    for conf in config.get(CONF_PACKS, []):
+        pack = cg.new_Pvariable(conf[CONF_ID])
+        await register_basen_bms(pack, conf)
+        cg.add(pack.set_link(var))
+
     cg.add(var.set_enable_fake_traffic(config[CONF_ENABLE_FAKE_TRAFFIC]))
+    cg.add(var.set_balancing_bitmap(config[CONF_EXPERIMENTAL_BALANCING_BITMAP]))
+    cg.add(var.set_cell_statistics_window(config[CONF_CELL_STATISTICS_WINDOW]))
+    cg.add(
+        var.set_cell_statistics_smoothing(config[CONF_CELL_STATISTICS_SMOOTHING])
+    )
+    cg.add(
+        var.set_internal_resistance_current_step(
+            config[CONF_INTERNAL_RESISTANCE_CURRENT_STEP]
+        )
+    )
+
+    if CONF_HISTORY_SIZE in config:
+        cg.add(var.set_history_size(config[CONF_HISTORY_SIZE]))
+
+    if CONF_ADAPTIVE_POLLING in config:
+        conf = config[CONF_ADAPTIVE_POLLING]
+        cg.add(
+            var.set_adaptive_polling(
+                conf[CONF_MIN_UPDATE_INTERVAL],
+                conf[CONF_MAX_UPDATE_INTERVAL],
+                conf[CONF_CURRENT_THRESHOLD],
+                conf[CONF_VOLTAGE_RATE_THRESHOLD],
+            )
+        )
+    request_frames(
+        var,
+        config,
+        {
+            CONF_ADAPTIVE_POLLING: [FRAME_TYPE_STATUS],
+            CONF_HISTORY_SIZE: [FRAME_TYPE_STATUS] + FRAME_TYPES_CELL_VOLTAGES[:2],
+        },
+    )
+
+    for key, (args, frame_types) in THRESHOLD_TRIGGERS.items():
+        for conf in config.get(key, []):
+            trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+            cg.add(trigger.set_threshold(conf[CONF_THRESHOLD]))
+            cg.add(trigger.set_hysteresis(conf[CONF_HYSTERESIS]))
+            await automation.build_automation(trigger, args, conf)
+    request_frames(
+        var, config, {key: frames for key, (_, frames) in THRESHOLD_TRIGGERS.items()}
+    )
+
+    for conf in config.get(CONF_ON_WARNING_RAISED, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+        await automation.build_automation(trigger, [(cg.std_string, "warning")], conf)
+    request_frames(var, config, {CONF_ON_WARNING_RAISED: [FRAME_TYPE_STATUS]})
+
+
+def final_validate_balancing_bitmap(keys):
+    """Require the experimental balancing bitmap of the hub for entities fed by it."""
+
+    def validator(config):
+        if not any(key in config for key in keys):
+            return config
+        full_config = fv.full_config.get()
+        path = full_config.get_path_for_id(config[CONF_BASEN_BMS_BLE_ID])[:-1]
+        hub_config = full_config.get_config_for_path(path)
+        if not hub_config.get(CONF_EXPERIMENTAL_BALANCING_BITMAP, False):
+            raise cv.Invalid(
+                f"{', '.join(key for key in keys if key in config)} requires "
+                f"'{CONF_EXPERIMENTAL_BALANCING_BITMAP}: true' at the hub"
+            )
+        return config
+
+    return validator
+
+
+def request_frames(hub, config, frame_types):
+    """Request only the frames required by the configured entities of a platform."""
+    requested = set()
+    for key, frames in frame_types.items():
+        if key in config:
+            requested.update(frames)
+    for frame_type in sorted(requested):
+        cg.add(hub.request_frame(frame_type))
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "esphome/core/automation.h"
+#include "basen_bms.h"
+
+namespace esphome {
+namespace basen_bms_ble {
+
+// Raises once per channel if the value crosses the threshold and rearms if the value returned by the hysteresis
+class ThresholdDetector {
+ public:
+  explicit ThresholdDetector(bool rising) : rising_(rising) {}
+  void set_threshold(float threshold) { this->threshold_ = threshold; }
+  void set_hysteresis(float hysteresis) { this->hysteresis_ = hysteresis; }
+
+  bool is_raised(uint8_t channel, float value) {
+    const uint64_t mask = uint64_t(1) << (channel & 63);
+    const bool active = this->active_ & mask;
+    const float distance = this->rising_ ? value - this->threshold_ : this->threshold_ - value;
+
+    if (!active && distance > 0.0f) {
+      this->active_ |= mask;
+      return true;
+    }
+    if (active && distance < -this->hysteresis_) {
+      this->active_ &= ~mask;
+    }
+    return false;
+  }
+
+ protected:
+  bool rising_;
+  float threshold_{0.0f};
+  float hysteresis_{0.0f};
+  uint64_t active_{0};
+};
+
+class CellOvervoltageTrigger : public Trigger<uint8_t, float>, public ThresholdDetector {
+ public:
+  explicit CellOvervoltageTrigger(BasenBms *parent) : ThresholdDetector(true) {
+    parent->add_on_cell_voltage_callback([this](uint8_t cell, float voltage) {
+      if (this->is_raised(cell, voltage))
+        this->trigger(cell, voltage);
+    });
+  }
+};
+
+class CellUndervoltageTrigger : public Trigger<uint8_t, float>, public ThresholdDetector {
+ public:
+  explicit CellUndervoltageTrigger(BasenBms *parent) : ThresholdDetector(false) {
+    parent->add_on_cell_voltage_callback([this](uint8_t cell, float voltage) {
+      if (this->is_raised(cell, voltage))
+        this->trigger(cell, voltage);
+    });
+  }
+};
+
+class OvertemperatureTrigger : public Trigger<uint8_t, float>, public ThresholdDetector {
+ public:
+  explicit OvertemperatureTrigger(BasenBms *parent) : ThresholdDetector(true) {
+    parent->add_on_temperature_callback([this](uint8_t sensor, float temperature) {
+      if (this->is_raised(sensor, temperature))
+        this->trigger(sensor, temperature);
+    });
+  }
+};
+
+class DeltaExceededTrigger : public Trigger<float>, public ThresholdDetector {
+ public:
+  explicit DeltaExceededTrigger(BasenBms *parent) : ThresholdDetector(true) {
+    parent->add_on_delta_cell_voltage_callback([this](float delta) {
+      if (this->is_raised(0, delta))
+        this->trigger(delta);
+    });
+  }
+};
+
+class WarningRaisedTrigger : public Trigger<std::string> {
+ public:
+  explicit WarningRaisedTrigger(BasenBms *parent) {
+    parent->add_on_warning_raised_callback([this](const std::string &warning) { this->trigger(warning); });
+  }
+};
+
+}  // namespace basen_bms_ble
+}  // namespace esphome
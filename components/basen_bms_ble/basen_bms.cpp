@@ -0,0 +1,1327 @@
+#include "basen_bms.h"
+#include "esphome/core/log.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+
+#include <ctime>
+
+namespace esphome {
+namespace basen_bms_ble {
+
+static const char *const TAG = "basen_bms";
+
+static const uint32_t MAX_DECODE_TIME_PER_LOOP_MS = 10;
+// A pack which doesn't respond within this time releases the link for the next pack
+static const uint32_t LINK_RESPONSE_TIMEOUT_MS = 2000;
+// History records require a synchronized clock (2020-01-01)
+static const time_t MIN_HISTORY_TIMESTAMP = 1577836800;
+
+// Frames are only requested if at least one configured entity depends on them (see request_frame())
+static const uint8_t BASEN_COMMAND_QUEUE_SIZE = 6;
+static const uint8_t BASEN_COMMAND_QUEUE[BASEN_COMMAND_QUEUE_SIZE] = {
+    BASEN_FRAME_TYPE_STATUS,
+    BASEN_FRAME_TYPE_GENERAL_INFO,
+    BASEN_FRAME_TYPE_CELL_VOLTAGES_1_12,
+    BASEN_FRAME_TYPE_CELL_VOLTAGES_13_24,
+    BASEN_FRAME_TYPE_CELL_VOLTAGES_25_34,
+    BASEN_FRAME_TYPE_BALANCING,
+};
+
+// Protection bits of the charging (SOCC, OTC, UTC, COV, FC) and discharging (SOCD, OTD, UTD, CUV, FD, ASCD, TDA)
+// states which trigger a read of the protect IC frame
+static const uint8_t CHARGING_PROTECTIONS_MASK = 0x1F;
+static const uint8_t DISCHARGING_PROTECTIONS_MASK = 0x7F;
+
+// Temperatures outside of this range are considered as sensor faults
+static const int8_t MIN_TEMPERATURE = -40;
+static const int8_t MAX_TEMPERATURE = 100;
+
+static const uint8_t CHARGING_STATES_SIZE = 8;
+static const char *const CHARGING_STATES[CHARGING_STATES_SIZE] = {
+    "Overcurrent protection (SOCC)",  // 0000 0001
+    "Over temperature (OTC)",         // 0000 0010
+    "Undertemperature (UTC)",         // 0000 0100
+    "Cell overvoltage (COV)",         // 0000 1000
+    "Battery overvoltage (FC)",       // 0001 0000
+    "Reserved",                       // 0010 0000
+    "Reserved",                       // 0100 0000
+    "Charging MOS (CHG)",             // 1000 0000
+};
+
+static const uint8_t CHARGING_WARNINGS_SIZE = 8;
+static const char *const CHARGING_WARNINGS[CHARGING_WARNINGS_SIZE] = {
+    "Overcurrent (OCC1)",          // 0000 0001
+    "Over temperature (OTC)",      // 0000 0010
+    "Undertemperature (UTC1)",     // 0000 0100
+    "Differential Pressure (DP)",  // 0000 1000
+    "Fully charged (FC)",          // 0001 0000
+    "Reserved",                    // 0010 0000
+    "Reserved",                    // 0100 0000
+    "Reserved",                    // 1000 0000
+};
+
+static const uint8_t DISCHARGING_STATES_SIZE = 8;
+static const char *const DISCHARGING_STATES[DISCHARGING_STATES_SIZE] = {
+    "Overcurrent protection (SOCD)",    // 0000 0001
+    "Over temperature (OTD)",           // 0000 0010
+    "Undertemperature (UTD)",           // 0000 0100
+    "Battery undervoltage (CUV)",       // 0000 1000
+    "Battery empty (FD)",               // 0001 0000
+    "Short circuit protection (ASCD)",  // 0010 0000
+    "Termination of discharge (TDA)",   // 0100 0000
+    "Discharging MOS (DSG)",            // 1000 0000
+};
+
+static const uint8_t DISCHARGING_WARNINGS_SIZE = 8;
+static const char *const DISCHARGING_WARNINGS[DISCHARGING_WARNINGS_SIZE] = {
+    "Overcurrent (OCD1)",                     // 0000 0001
+    "Over temperature (OTD1)",                // 0000 0010
+    "Undertemperature (UTD1)",                // 0000 0100
+    "Differential Pressure (DP)",             // 0000 1000
+    "Not enough time left (RTA)",             // 0001 0000
+    "Insufficient capacity remaining (RCA)",  // 0010 0000
+    "Battery undervoltage (CUV)",             // 0100 0000
+    "Battery empty (FD)",                     // 1000 0000
+};
+
+void BasenBms::assemble_(const uint8_t *data, uint16_t length) {
+  if (length == 0) {
+    return;
+  }
+
+  // A preamble starts a new frame unless the fragment fits into the frame announced by the buffered header
+  // (a data byte of 0x3A or 0x3B at the start of a continuation fragment)
+  if (data[0] == BASEN_PKT_START_A || data[0] == BASEN_PKT_START_B) {
+    if (this->frame_buffer_.size() < 4 ||
+        this->frame_buffer_.size() + length > 4 + (size_t) this->frame_buffer_[3] + 4) {
+      this->frame_buffer_.clear();
+    }
+  } else if (this->frame_buffer_.empty()) {
+    // Orphan fragment, e.g. the tail of a frame whose head was lost
+    ESP_LOGW(TAG, "Fragment without preamble dropped");
+    this->state_.length_errors++;
+    return;
+  }
+
+  // The buffer never grows beyond the largest frame: every byte is copied and checksummed once at most
+  if (this->frame_buffer_.size() + length > MAX_RESPONSE_SIZE) {
+    ESP_LOGW(TAG, "Maximum response size exceeded");
+    this->state_.length_errors++;
+    this->discard_frame_();
+    return;
+  }
+
+  this->frame_buffer_.reserve(MAX_RESPONSE_SIZE);
+  this->frame_buffer_.insert(this->frame_buffer_.end(), data, data + length);
+
+  // The frame is complete if the length announced by the header is buffered. A fragment ending in 0x0A doesn't
+  // complete a frame by itself: it may end with a data byte of 0x0A.
+  if (this->frame_buffer_.size() < 4) {
+    return;
+  }
+
+  // Start of frame, address, frame type, data length, CRC and end of frame
+  const uint8_t *raw = &this->frame_buffer_[0];
+  uint16_t data_len = raw[3];
+  uint16_t frame_len = 4 + data_len + 4;
+  if (frame_len > MAX_RESPONSE_SIZE) {
+    ESP_LOGW(TAG, "Invalid frame length");
+    this->state_.length_errors++;
+    this->discard_frame_();
+    return;
+  }
+
+  if (this->frame_buffer_.size() < frame_len) {
+    return;
+  }
+
+  if (this->frame_buffer_.size() > frame_len || raw[frame_len - 1] != BASEN_PKT_END_2) {
+    ESP_LOGW(TAG, "Invalid frame length");
+    this->state_.length_errors++;
+    this->discard_frame_();
+    return;
+  }
+
+  uint16_t computed_crc = chksum_(raw + 1, data_len + 3);
+  uint16_t remote_crc = uint16_t(raw[frame_len - 3]) << 8 | (uint16_t(raw[frame_len - 4]) << 0);
+  if (computed_crc != remote_crc) {
+    ESP_LOGW(TAG, "CRC check failed! 0x%04X != 0x%04X", computed_crc, remote_crc);
+    this->state_.crc_errors++;
+    this->discard_frame_();
+    return;
+  }
+
+  // Demultiplex the frame by address into the state of the pack
+  BasenBms *pack = this->find_pack_(raw[1]);
+  if (pack == nullptr) {
+    ESP_LOGW(TAG, "Frame 0x%02X of unknown address 0x%02X dropped", raw[2], raw[1]);
+    this->state_.unknown_address_frames++;
+    this->discard_frame_();
+    return;
+  }
+
+  // The protect IC read is decided on the receive path: the command following the status frame is sent
+  // before the status frame is decoded in loop()
+  if (raw[2] == BASEN_FRAME_TYPE_STATUS && frame_len >= 4 + 25 + 4) {
+    pack->update_protect_ic_due_(raw);
+  }
+
+  // Defer decoding and publishing to loop() to keep the BLE event path short
+  pack->state_.frames_received++;
+  switch (pack->frame_queue_.push(raw, frame_len - 4)) {
+    case FramePushResult::QUEUED:
+      break;
+    case FramePushResult::QUEUE_FULL:
+      ESP_LOGW(TAG, "Frame queue full. Frame 0x%02X dropped", raw[2]);
+      break;
+    case FramePushResult::OVERSIZE:
+      ESP_LOGW(TAG, "Frame 0x%02X exceeds the frame queue slot size", raw[2]);
+      this->state_.length_errors++;
+      break;
+  }
+  this->frame_buffer_.clear();
+
+  // Send next command after the response to the outstanding command. Unsolicited frames don't advance the link
+  if (this->response_pending_) {
+    this->response_pending_ = false;
+    this->send_next_link_command_();
+  }
+}
+
+void BasenBms::update_protect_ic_due_(const uint8_t *status) {
+  // Temperature 3 and 4 (bytes 14 and 15) fall back to the protect IC frame if the status frame reports
+  // implausible values
+  bool temperature_fallback = false;
+  for (uint8_t i = 2; i < 4; i++) {
+    int8_t temperature = (int8_t) status[12 + i];
+    if (temperature < MIN_TEMPERATURE || temperature > MAX_TEMPERATURE) {
+      temperature_fallback |= (this->temperatures_[i].temperature_sensor_ != nullptr);
+    }
+  }
+
+  // Read the protect IC frame at the end of a cycle on demand only
+  this->protect_ic_due_ = temperature_fallback || (status[20] & CHARGING_PROTECTIONS_MASK) ||
+                          (status[21] & DISCHARGING_PROTECTIONS_MASK);
+}
+
+void BasenBms::discard_frame_() {
+  this->frame_buffer_.clear();
+
+  // Don't wait for the response timeout: the response to the outstanding command is lost, continue with the next
+  // command. The link advances once per command only, so two requests are never in flight
+  if (this->response_pending_) {
+    this->response_pending_ = false;
+    this->send_next_link_command_();
+  }
+}
+
+BasenBms *BasenBms::find_pack_(uint8_t address) {
+  for (auto *pack : this->packs_) {
+    if (pack->address_ == address) {
+      return pack;
+    }
+  }
+
+  return nullptr;
+}
+
+void BasenBms::schedule_poll_(BasenBms *pack) {
+  pack->poll_pending_ = true;
+
+  if (this->active_pack_ != nullptr) {
+    if (millis() - this->last_command_timestamp_ < LINK_RESPONSE_TIMEOUT_MS) {
+      return;
+    }
+    ESP_LOGW(TAG, "No response of pack 0x%02X. Releasing the link", this->active_pack_->address_);
+    this->active_pack_ = nullptr;
+    this->response_pending_ = false;
+  }
+
+  this->send_next_link_command_();
+}
+
+void BasenBms::send_next_link_command_() {
+  // Complete the poll cycle of the active pack before the next pending pack (round-robin) is polled
+  for (uint8_t attempt = 0; attempt <= this->packs_.size(); attempt++) {
+    if (this->active_pack_ == nullptr) {
+      for (uint8_t i = 0; i < this->packs_.size() && this->active_pack_ == nullptr; i++) {
+        BasenBms *pack = this->packs_[(this->next_pack_ + i) % this->packs_.size()];
+        if (pack->poll_pending_) {
+          pack->poll_pending_ = false;
+          pack->next_command_ = 0;
+          this->active_pack_ = pack;
+          this->next_pack_ = (this->next_pack_ + i + 1) % this->packs_.size();
+        }
+      }
+      if (this->active_pack_ == nullptr) {
+        return;
+      }
+    }
+
+    // Set before sending: the fake traffic mode responds within send_next_command_()
+    this->last_command_timestamp_ = millis();
+    this->response_pending_ = true;
+    if (this->active_pack_->send_next_command_()) {
+      return;
+    }
+    this->response_pending_ = false;
+    this->active_pack_ = nullptr;
+  }
+}
+
+void BasenBms::setup() {
+  // Poll every frame if no entity requested one (e.g. a debug or fake traffic setup without entities)
+  if (this->requested_frames_ == 0) {
+    this->requested_frames_ = (1 << BASEN_COMMAND_QUEUE_SIZE) - 1;
+  }
+
+  if (this->history_size_ == 0) {
+    return;
+  }
+
+  ExternalRAMAllocator<uint8_t> allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
+  uint8_t *buffer = allocator.allocate(this->history_size_);
+  if (!this->history_.init(buffer, this->history_size_)) {
+    ESP_LOGE(TAG, "Could not allocate %u bytes for the history", (unsigned) this->history_size_);
+    if (buffer != nullptr) {
+      allocator.deallocate(buffer, this->history_size_);
+    }
+  }
+}
+
+void BasenBms::loop() {
+  // Decode at least one frame per iteration and stop if the time budget is exhausted
+  const uint32_t start = millis();
+  while (this->frame_queue_.pop(this->decode_buffer_)) {
+    this->on_basen_bms_data_(this->decode_buffer_);
+
+    if (millis() - start >= MAX_DECODE_TIME_PER_LOOP_MS) {
+      break;
+    }
+  }
+}
+
+void BasenBms::update() {
+  this->publish_state_(this->frame_queue_depth_sensor_, (float) this->frame_queue_.reset_high_water());
+  this->publish_state_(this->dropped_frames_sensor_, (float) this->frame_queue_.dropped());
+  if (this->min_update_interval_ == 0) {
+    // Published by adapt_update_interval_() if adaptive polling is enabled
+    this->publish_state_(this->effective_update_interval_sensor_, this->get_update_interval() * 0.001f);
+  }
+
+  if (!this->is_connected_() && !this->enable_fake_traffic_) {
+    ESP_LOGW(TAG, "Not connected");
+    return;
+  }
+
+  // Loop through all requested commands if connected. Packs sharing a link are polled one after another
+  if (this->is_command_queue_pending_()) {
+    ESP_LOGW(TAG,
+             "Command queue (%d of %d) was not completely processed. "
+             "Please increase the update_interval if you see this warning frequently",
+             this->next_command_ + 1, BASEN_COMMAND_QUEUE_SIZE);
+  }
+  this->get_link_()->schedule_poll_(this);
+}
+
+const PackState &BasenBms::get_state() {
+  this->state_.address = this->address_;
+  this->state_.cell_count = this->cell_count_;
+  std::copy(std::begin(this->cell_voltages_), std::end(this->cell_voltages_), this->state_.cell_voltages);
+  this->state_.balancing_cells = this->balancing_cells_;
+  this->state_.balancing_cells_valid = this->balancing_bitmap_ && this->balancing_cells_published_;
+  this->state_.update_interval = this->get_update_interval() * 0.001f;
+  this->state_.dropped_frames = this->frame_queue_.dropped();
+  return this->state_;
+}
+
+void BasenBms::request_frame(uint8_t frame_type) {
+  for (uint8_t i = 0; i < BASEN_COMMAND_QUEUE_SIZE; i++) {
+    if (BASEN_COMMAND_QUEUE[i] == frame_type) {
+      this->requested_frames_ |= (1 << i);
+      return;
+    }
+  }
+
+  ESP_LOGW(TAG, "Frame type 0x%02X cannot be requested", frame_type);
+}
+
+bool BasenBms::is_frame_requested_(uint8_t frame_type) {
+  for (uint8_t i = 0; i < BASEN_COMMAND_QUEUE_SIZE; i++) {
+    if (BASEN_COMMAND_QUEUE[i] == frame_type) {
+      return (this->requested_frames_ & (1 << i)) != 0;
+    }
+  }
+
+  return false;
+}
+
+bool BasenBms::is_frame_due_(uint8_t frame_type) {
+  if (!this->is_frame_requested_(frame_type)) {
+    return false;
+  }
+
+  // Skip the cell voltage chunks beyond the known number of cells
+  if (this->cell_count_hint_ > 0 && frame_type >= BASEN_FRAME_TYPE_CELL_VOLTAGES_1_12 &&
+      frame_type <= BASEN_FRAME_TYPE_CELL_VOLTAGES_25_34) {
+    return 12 * (frame_type - BASEN_FRAME_TYPE_CELL_VOLTAGES_1_12) < this->cell_count_hint_;
+  }
+
+  return true;
+}
+
+bool BasenBms::is_link_idle_() {
+  if (this->active_pack_ != nullptr) {
+    return false;
+  }
+
+  for (auto *pack : this->packs_) {
+    if (pack->poll_pending_ || pack->frame_queue_.size() > 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool BasenBms::is_command_queue_pending_() {
+  if (this->next_command_ >= BASEN_COMMAND_QUEUE_SIZE) {
+    return false;
+  }
+
+  return (this->requested_frames_ >> this->next_command_) != 0;
+}
+
+bool BasenBms::send_next_command_() {
+  // Skip all frames without a configured consumer
+  while (this->next_command_ < BASEN_COMMAND_QUEUE_SIZE) {
+    uint8_t index = this->next_command_++;
+    if (this->is_frame_due_(BASEN_COMMAND_QUEUE[index])) {
+      return this->send_command_(BASEN_PKT_START_A, BASEN_COMMAND_QUEUE[index]);
+    }
+  }
+
+  // The protect IC frame reports the temperatures 3 and 4 only if requested with the alternative start of frame
+  if (this->protect_ic_due_) {
+    this->protect_ic_due_ = false;
+    return this->send_command_(BASEN_PKT_START_B, BASEN_FRAME_TYPE_PROTECT_IC);
+  }
+
+  return false;
+}
+
+void BasenBms::on_basen_bms_data_(const std::vector<uint8_t> &data) {
+  // The frames are validated by assemble_(): the data length matches the frame size
+  if (data.size() < 4) {
+    ESP_LOGW(TAG, "Invalid frame length");
+    return;
+  }
+
+  uint8_t frame_type = data[2];
+
+  switch (frame_type) {
+    case BASEN_FRAME_TYPE_STATUS:
+      this->decode_status_data_(data);
+      break;
+    case BASEN_FRAME_TYPE_GENERAL_INFO:
+      this->decode_general_info_data_(data);
+      break;
+    case BASEN_FRAME_TYPE_CELL_VOLTAGES_1_12:
+    case BASEN_FRAME_TYPE_CELL_VOLTAGES_13_24:
+    case BASEN_FRAME_TYPE_CELL_VOLTAGES_25_34:
+      this->decode_cell_voltages_data_(data);
+      break;
+    case BASEN_FRAME_TYPE_PROTECT_IC:
+      this->decode_protect_ic_data_(data);
+      break;
+    case BASEN_FRAME_TYPE_BALANCING:
+      this->decode_balancing_data_(data);
+      break;
+    default:
+      ESP_LOGW(TAG, "Unhandled response received (frame_type 0x%02X): %s", frame_type,
+               format_hex_pretty(&data.front(), data.size()).c_str());
+  }
+}
+
+void BasenBms::decode_status_data_(const std::vector<uint8_t> &data) {
+  auto basen_get_16bit = [&](size_t i) -> uint16_t {
+    return (uint16_t(data[i + 1]) << 8) | (uint16_t(data[i + 0]) << 0);
+  };
+  auto basen_get_32bit = [&](size_t i) -> uint32_t {
+    return (uint32_t(basen_get_16bit(i + 2)) << 16) | (uint32_t(basen_get_16bit(i + 0)) << 0);
+  };
+
+  ESP_LOGI(TAG, "Status frame (%u+4 bytes):", (unsigned) data.size());
+  ESP_LOGD(TAG, "  %s", format_hex_pretty(&data.front(), data.size()).c_str());
+
+  if (data.size() < 25) {
+    ESP_LOGW(TAG, "Invalid status frame length");
+    return;
+  }
+
+  // Byte Len Payload              Description                      Unit  Precision
+  //  0    1  0x3B                 Start of frame
+  //  1    1  0x16                 Address
+  //  2    1  0x2A                 Frame type
+  //  3    1  0x18                 Data length
+  //  4    4  0x00 0x00 0x00 0x00  Current (without calibration)    A     0.001f
+  float current = ((int32_t) basen_get_32bit(4)) * 0.001f;
+  this->publish_state_(this->current_sensor_, current);
+  this->state_.current = current;
+
+  //  8    4  0xCE 0x61 0x00 0x00  Total voltage                    V     0.001f
+  float total_voltage = basen_get_32bit(8) * 0.001f;
+  this->publish_state_(this->total_voltage_sensor_, total_voltage);
+  this->state_.total_voltage = total_voltage;
+
+  float power = total_voltage * current;
+  this->state_.power = power;
+  this->publish_state_(this->power_sensor_, power);
+  this->publish_state_(this->charging_power_sensor_, std::max(0.0f, power));               // 500W vs 0W -> 500W
+  this->publish_state_(this->discharging_power_sensor_, std::abs(std::min(0.0f, power)));  // -500W vs 0W -> 500W
+
+  this->resistance_estimator_.update_pack(total_voltage, current, millis());
+  if (!std::isnan(this->resistance_estimator_.get_pack_resistance())) {
+    this->publish_state_(this->internal_resistance_sensor_,
+                         this->resistance_estimator_.get_pack_resistance() * 1000.0f);
+  }
+
+  //  12   1  0x12                 Temperature 1                    °C    1.0f
+  //  13   1  0x14                 Temperature 2                    °C    1.0f
+  //  14   1  0x19                 Temperature 3                    °C    1.0f
+  //  15   1  0x19                 Temperature 4                    °C    1.0f
+  //
+  // Temperature 3 and 4 fall back to the protect IC frame if the status frame reports implausible values
+  for (uint8_t i = 0; i < 4; i++) {
+    int8_t temperature = (int8_t) data[12 + i];
+    if (i >= 2 && (temperature < MIN_TEMPERATURE || temperature > MAX_TEMPERATURE)) {
+      continue;
+    }
+    this->publish_temperature_(i, (float) temperature);
+  }
+
+  //  16   4  0x63 0x23 0x00 0x00  Capacity remaining               Ah    0.001f
+  this->publish_state_(this->capacity_remaining_sensor_, basen_get_32bit(16) * 0.001f);
+  this->state_.capacity_remaining = basen_get_32bit(16) * 0.001f;
+
+  //  20   1  0x80                 Charging states (Bitmask)
+  this->publish_state_(this->charging_states_bitmask_sensor_, data[20]);
+  this->state_.charging_states = data[20];
+  if (this->charging_states_text_sensor_ != nullptr) {
+    this->publish_state_(this->charging_states_text_sensor_, this->charging_states_bits_to_string_(data[20]));
+  }
+  this->publish_state_(this->charging_binary_sensor_, (bool) (data[20] & (1 << 7)));
+  this->publish_state_(this->charging_switch_, (bool) (data[20] & (1 << 7)));
+
+  //  21   1  0x80                 Discharging states (Bitmask)
+  this->publish_state_(this->discharging_states_bitmask_sensor_, data[21]);
+  this->state_.discharging_states = data[21];
+  if (this->discharging_states_text_sensor_ != nullptr) {
+    this->publish_state_(this->discharging_states_text_sensor_, this->discharging_states_bits_to_string_(data[21]));
+  }
+  this->publish_state_(this->discharging_binary_sensor_, (bool) (data[21] & (1 << 7)));
+  this->publish_state_(this->discharging_switch_, (bool) (data[21] & (1 << 7)));
+
+  //  22   1  0x00                 Charging warnings (Bitmask)
+  this->publish_state_(this->charging_warnings_bitmask_sensor_, data[22]);
+  this->state_.charging_warnings = data[22];
+  if (this->charging_warnings_text_sensor_ != nullptr) {
+    this->publish_state_(this->charging_warnings_text_sensor_, this->charging_warnings_bits_to_string_(data[22]));
+  }
+
+  //  23   1  0x00                 Discharging warnings (Bitmask)
+  this->publish_state_(this->discharging_warnings_bitmask_sensor_, data[23]);
+  this->state_.discharging_warnings = data[23];
+  if (this->discharging_warnings_text_sensor_ != nullptr) {
+    this->publish_state_(this->discharging_warnings_text_sensor_,
+                         this->discharging_warnings_bits_to_string_(data[23]));
+  }
+  this->check_warnings_(data[22], data[23]);
+
+  //  24   1  0x08                 State of charge                  %     1.0f
+  this->publish_state_(this->state_of_charge_sensor_, (float) data[24]);
+  this->state_.state_of_charge = data[24];
+
+  this->history_record_.values[HISTORY_TOTAL_VOLTAGE] = (int32_t) basen_get_32bit(8);
+  this->history_record_.values[HISTORY_CURRENT] = ((int32_t) basen_get_32bit(4)) / 10;
+  this->history_record_.values[HISTORY_CAPACITY_REMAINING] = (int32_t) basen_get_32bit(16);
+  this->history_record_.values[HISTORY_STATE_OF_CHARGE] = data[24];
+  this->history_record_.values[HISTORY_STATE_MASKS] = (int32_t) basen_get_32bit(20);
+  for (uint8_t i = 0; i < 4; i++) {
+    this->history_record_.values[HISTORY_TEMPERATURE_1 + i] = (int8_t) data[12 + i];
+  }
+
+  uint8_t charging_protections = data[20] & CHARGING_PROTECTIONS_MASK;
+  uint8_t discharging_protections = data[21] & DISCHARGING_PROTECTIONS_MASK;
+  if (charging_protections != this->charging_protections_ ||
+      discharging_protections != this->discharging_protections_ || !this->protections_published_) {
+    if (charging_protections || discharging_protections) {
+      ESP_LOGW(TAG, "Protection tripped (charging 0x%02X, discharging 0x%02X)", charging_protections,
+               discharging_protections);
+    }
+    this->charging_protections_ = charging_protections;
+    this->discharging_protections_ = discharging_protections;
+    this->protections_published_ = true;
+    if (this->protection_faults_text_sensor_ != nullptr) {
+      std::string faults = this->charging_states_bits_to_string_(charging_protections);
+      std::string discharging_faults = this->discharging_states_bits_to_string_(discharging_protections);
+      if (!faults.empty() && !discharging_faults.empty()) {
+        faults.append(";");
+      }
+      faults.append(discharging_faults);
+      this->publish_state_(this->protection_faults_text_sensor_, faults);
+    }
+  }
+
+  this->adapt_update_interval_(current, total_voltage, basen_get_32bit(20));
+
+  // Without cell voltages the history is recorded per status frame, otherwise after the last cell voltage frame
+  if (!this->is_frame_due_(BASEN_FRAME_TYPE_CELL_VOLTAGES_1_12)) {
+    this->record_history_();
+  }
+
+  //  25   1  0x19                 Unused
+  //  26   1  0x00                 Unused
+  //  27   1  0x00                 Unused
+  //  28   1  0x6F                 CRC
+  //  29   1  0x03                 CRC
+  //  30   1  0x0D                 End of frame
+  //  31   1  0x0A                 End of frame
+}
+
+void BasenBms::decode_general_info_data_(const std::vector<uint8_t> &data) {
+  auto basen_get_16bit = [&](size_t i) -> uint16_t {
+    return (uint16_t(data[i + 1]) << 8) | (uint16_t(data[i + 0]) << 0);
+  };
+  auto basen_get_32bit = [&](size_t i) -> uint32_t {
+    return (uint32_t(basen_get_16bit(i + 2)) << 16) | (uint32_t(basen_get_16bit(i + 0)) << 0);
+  };
+
+  ESP_LOGI(TAG, "General info frame (%u+4 bytes):", (unsigned) data.size());
+  ESP_LOGD(TAG, "  %s", format_hex_pretty(&data.front(), data.size()).c_str());
+
+  if (data.size() < 28) {
+    ESP_LOGW(TAG, "Invalid general info frame length");
+    return;
+  }
+
+  // Byte Len Payload              Description                      Unit  Precision
+  //  0    1  0x3A                 Start of frame
+  //  1    1  0x16                 Address
+  //  2    1  0x2B                 Frame type
+  //  3    1  0x18                 Data length
+  //  4    4  0xA0 0x86 0x01 0x00  Nominal capacity                 Ah    0.001f
+  this->publish_state_(this->nominal_capacity_sensor_, basen_get_32bit(4) * 0.001f);
+  this->state_.nominal_capacity = basen_get_32bit(4) * 0.001f;
+
+  //  8    4  0x00 0x64 0x00 0x00  Nominal voltage                  V     0.001f
+  this->publish_state_(this->nominal_voltage_sensor_, basen_get_32bit(8) * 0.001f);
+  this->state_.nominal_voltage = basen_get_32bit(8) * 0.001f;
+
+  //  12   4  0x91 0xA0 0x01 0x00  Real capacity                    Ah    0.001f
+  this->publish_state_(this->real_capacity_sensor_, basen_get_32bit(12) * 0.001f);
+  this->state_.real_capacity = basen_get_32bit(12) * 0.001f;
+
+  //  16   1  0x00                 Unused
+  //  17   1  0x00                 Unused
+  //  18   1  0x00                 Unused
+  //  19   1  0x00                 Unused
+  //  20   1  0x30                 Unused
+  //  21   1  0x75                 Unused
+  //  22   2  0x00 0x00            Serial number
+  this->publish_state_(this->serial_number_sensor_, (float) basen_get_16bit(22));
+  this->state_.serial_number = basen_get_16bit(22);
+
+  //  24   2  0x71 0x53            Manufacturing date
+  if (this->manufacturing_date_text_sensor_ != nullptr) {
+    uint16_t raw_date = basen_get_16bit(24);
+    uint16_t year = ((raw_date >> 9) & 127) + 1980;
+    uint8_t month = (raw_date >> 5) & 15;
+    uint8_t day = 31 & raw_date;
+    this->publish_state_(this->manufacturing_date_text_sensor_,
+                         to_string(year) + "." + to_string(month) + "." + to_string(day));
+  }
+
+  //  26   2  0x07 0x00            Charging cycles
+  this->publish_state_(this->charging_cycles_sensor_, (float) basen_get_16bit(26));
+  this->state_.charging_cycles = basen_get_16bit(26);
+
+  //  28   1  0x86                 CRC
+  //  29   1  0x04                 CRC
+  //  30   1  0x0D                 End of frame
+  //  31   1  0x0A                 End of frame
+}
+
+void BasenBms::decode_cell_voltages_data_(const std::vector<uint8_t> &data) {
+  auto basen_get_16bit = [&](size_t i) -> uint16_t {
+    return (uint16_t(data[i + 1]) << 8) | (uint16_t(data[i + 0]) << 0);
+  };
+
+  uint8_t offset = 12 * (data[2] - 36);
+  uint8_t cells = (data.size() - 4) / 2;
+
+  ESP_LOGI(TAG, "Cell voltages frame (chunk %d, %u+4 bytes):", data[2] - 36, (unsigned) data.size());
+  ESP_LOGD(TAG, "  %s", format_hex_pretty(&data.front(), data.size()).c_str());
+
+  // Byte Len Payload              Description                      Unit  Precision
+  //  0    1  0x3A                 Start of frame
+  //  1    1  0x16                 Address
+  //  2    1  0x24                 Frame type
+  //  3    1  0x18                 Data length
+  //  4    2  0x96 0x0C            Cell voltage 1
+  //  6    2  0x97 0x0C            Cell voltage 2
+  //  8    2  0x98 0x0C            Cell voltage 3
+  //  10   2  0x96 0x0C            Cell voltage 4
+  //  12   2  0x96 0x0C            Cell voltage 5
+  //  14   2  0x98 0x0C            Cell voltage 6
+  //  16   2  0x98 0x0C            Cell voltage 7
+  //  18   2  0x97 0x0C            Cell voltage 8
+  //  20   2  0x00 0x00            Cell voltage 9
+  //  22   1  0x00 0x00            Cell voltage 10
+  //  24   1  0x00 0x00            Cell voltage 11
+  //  26   1  0x00 0x00            Cell voltage 12
+  for (uint8_t i = 0; i < cells && i + offset < 34; i++) {
+    uint16_t cell_voltage = basen_get_16bit((i * 2) + 4);
+    this->cell_voltages_[i + offset] = cell_voltage;
+    this->publish_state_(this->cells_[i + offset].cell_voltage_sensor_, cell_voltage * 0.001f);
+  }
+
+  // Publish aggregated sensors at the last requested chunk
+  uint8_t last_chunk = BASEN_FRAME_TYPE_CELL_VOLTAGES_13_24;
+  if (this->is_frame_due_(BASEN_FRAME_TYPE_CELL_VOLTAGES_25_34)) {
+    last_chunk = BASEN_FRAME_TYPE_CELL_VOLTAGES_25_34;
+  } else if (!this->is_frame_due_(BASEN_FRAME_TYPE_CELL_VOLTAGES_13_24) && this->cell_count_hint_ > 0) {
+    last_chunk = BASEN_FRAME_TYPE_CELL_VOLTAGES_1_12;
+  }
+  if (data[2] == last_chunk) {
+    this->publish_cell_voltage_aggregates_();
+    this->cell_statistics_.update(this->cell_voltages_, 34, millis());
+    this->publish_cell_statistics_();
+    this->resistance_estimator_.update_cells(this->cell_voltages_, 34, millis());
+    this->publish_cell_internal_resistances_();
+    this->record_history_();
+  }
+
+  //  28   1  0x6A                 CRC
+  //  29   1  0x05                 CRC
+  //  30   1  0x0D                 End of frame
+  //  31   1  0x0A                 End of frame
+}
+
+void BasenBms::publish_cell_voltage_aggregates_() {
+  uint16_t min_cell_voltage = UINT16_MAX;
+  uint16_t max_cell_voltage = 0;
+  uint8_t min_voltage_cell = 0;
+  uint8_t max_voltage_cell = 0;
+  uint32_t sum = 0;
+  uint8_t cells = 0;
+
+  for (uint8_t i = 0; i < 34; i++) {
+    uint16_t cell_voltage = this->cell_voltages_[i];
+    if (cell_voltage == 0) {
+      continue;
+    }
+    if (cell_voltage < min_cell_voltage) {
+      min_cell_voltage = cell_voltage;
+      min_voltage_cell = i + 1;
+    }
+    if (cell_voltage > max_cell_voltage) {
+      max_cell_voltage = cell_voltage;
+      max_voltage_cell = i + 1;
+    }
+    sum += cell_voltage;
+    cells++;
+    this->cell_count_ = i + 1;
+  }
+
+  if (cells == 0) {
+    return;
+  }
+
+  this->publish_state_(this->min_cell_voltage_sensor_, min_cell_voltage * 0.001f);
+  this->publish_state_(this->max_cell_voltage_sensor_, max_cell_voltage * 0.001f);
+  this->publish_state_(this->max_voltage_cell_sensor_, (float) max_voltage_cell);
+  this->publish_state_(this->min_voltage_cell_sensor_, (float) min_voltage_cell);
+  this->publish_state_(this->delta_cell_voltage_sensor_, (max_cell_voltage - min_cell_voltage) * 0.001f);
+  this->publish_state_(this->average_cell_voltage_sensor_, (sum / (float) cells) * 0.001f);
+
+  for (uint8_t i = 0; i < 34; i++) {
+    if (this->cell_voltages_[i] > 0) {
+      this->cell_voltage_callback_.call(i + 1, this->cell_voltages_[i] * 0.001f);
+    }
+  }
+  this->delta_cell_voltage_callback_.call((max_cell_voltage - min_cell_voltage) * 0.001f);
+}
+
+void BasenBms::record_history_() {
+  if (!this->history_.is_initialized()) {
+    return;
+  }
+
+  const time_t now = ::time(nullptr);
+  if (now < MIN_HISTORY_TIMESTAMP) {
+    ESP_LOGV(TAG, "Clock not synchronized yet. History record skipped");
+    return;
+  }
+
+  HistoryStore::Record &record = this->history_record_;
+  record.timestamp = (uint32_t) now;
+  record.channels = HISTORY_CELL_VOLTAGE_1;
+  for (uint8_t i = 0; i < this->cell_count_ && record.channels < HistoryStore::MAX_CHANNELS; i++) {
+    record.values[record.channels++] = this->cell_voltages_[i];
+  }
+
+  bool appended;
+  {
+    LockGuard guard(this->history_lock_);
+    appended = this->history_.append(record);
+  }
+  if (!appended) {
+    ESP_LOGW(TAG, "History record rejected (clock went backwards)");
+  }
+}
+
+void BasenBms::adapt_update_interval_(float current, float total_voltage, uint32_t state_masks) {
+  if (this->min_update_interval_ == 0) {
+    return;
+  }
+
+  const uint32_t now = millis();
+  bool active = std::abs(current) >= this->activity_current_threshold_ || state_masks != this->last_state_masks_;
+  if (!std::isnan(this->last_total_voltage_) && now != this->last_status_timestamp_) {
+    float voltage_rate = std::abs(total_voltage - this->last_total_voltage_) /
+                         ((now - this->last_status_timestamp_) / 1000.0f);
+    active |= voltage_rate >= this->activity_voltage_rate_threshold_;
+  }
+  this->last_total_voltage_ = total_voltage;
+  this->last_status_timestamp_ = now;
+  this->last_state_masks_ = state_masks;
+
+  // Poll at the highest rate on activity and back off exponentially at rest
+  uint32_t update_interval = this->get_update_interval();
+  uint32_t next_update_interval =
+      active ? this->min_update_interval_ : std::min(update_interval * 2, this->max_update_interval_);
+  next_update_interval = std::max(next_update_interval, this->min_update_interval_);
+
+  if (next_update_interval != update_interval) {
+    ESP_LOGD(TAG, "Pack %s, update interval changed to %u ms", active ? "active" : "at rest",
+             (unsigned) next_update_interval);
+    this->set_update_interval(next_update_interval);
+    this->stop_poller();
+    this->start_poller();
+  }
+  this->publish_state_(this->effective_update_interval_sensor_, next_update_interval * 0.001f);
+}
+
+void BasenBms::publish_temperature_(uint8_t temperature, float value) {
+  this->publish_state_(this->temperatures_[temperature].temperature_sensor_, value);
+  this->state_.temperatures[temperature] = value;
+  this->temperature_callback_.call(temperature + 1, value);
+}
+
+void BasenBms::check_warnings_(uint8_t charging_warnings, uint8_t discharging_warnings) {
+  uint8_t raised_charging_warnings = charging_warnings & ~this->charging_warnings_;
+  uint8_t raised_discharging_warnings = discharging_warnings & ~this->discharging_warnings_;
+  this->charging_warnings_ = charging_warnings;
+  this->discharging_warnings_ = discharging_warnings;
+
+  for (uint8_t i = 0; i < CHARGING_WARNINGS_SIZE; i++) {
+    if (raised_charging_warnings & (1 << i)) {
+      this->warning_raised_callback_.call(CHARGING_WARNINGS[i]);
+    }
+  }
+  for (uint8_t i = 0; i < DISCHARGING_WARNINGS_SIZE; i++) {
+    if (raised_discharging_warnings & (1 << i)) {
+      this->warning_raised_callback_.call(DISCHARGING_WARNINGS[i]);
+    }
+  }
+}
+
+void BasenBms::publish_cell_statistics_() {
+  float max_deviation = 0.0f;
+  float max_drift_rate = NAN;
+  uint8_t max_deviation_cell = 0;
+  uint8_t max_drift_cell = 0;
+  uint16_t rolling_min = UINT16_MAX;
+  uint16_t rolling_max = 0;
+
+  for (uint8_t i = 0; i < CellStatistics::MAX_CELLS; i++) {
+    if (!this->cell_statistics_.is_available(i)) {
+      continue;
+    }
+
+    float deviation = this->cell_statistics_.get_deviation(i);
+    if (max_deviation_cell == 0 || std::abs(deviation) > std::abs(max_deviation)) {
+      max_deviation = deviation;
+      max_deviation_cell = i + 1;
+    }
+
+    float drift_rate = this->cell_statistics_.get_drift_rate(i);
+    if (!std::isnan(drift_rate) && (std::isnan(max_drift_rate) || std::abs(drift_rate) > std::abs(max_drift_rate))) {
+      max_drift_rate = drift_rate;
+      max_drift_cell = i + 1;
+    }
+
+    rolling_min = std::min(rolling_min, this->cell_statistics_.get_rolling_min(i));
+    rolling_max = std::max(rolling_max, this->cell_statistics_.get_rolling_max(i));
+  }
+
+  if (max_deviation_cell == 0) {
+    return;
+  }
+
+  this->publish_state_(this->max_cell_deviation_sensor_, max_deviation * 0.001f);
+  this->publish_state_(this->max_deviation_cell_sensor_, (float) max_deviation_cell);
+  this->publish_state_(this->max_cell_drift_rate_sensor_, max_drift_rate);
+  this->publish_state_(this->max_drift_cell_sensor_, std::isnan(max_drift_rate) ? NAN : (float) max_drift_cell);
+  this->publish_state_(this->rolling_min_cell_voltage_sensor_, rolling_min * 0.001f);
+  this->publish_state_(this->rolling_max_cell_voltage_sensor_, rolling_max * 0.001f);
+}
+
+void BasenBms::publish_cell_internal_resistances_() {
+  float sum = 0.0f;
+  float max_resistance = NAN;
+  uint8_t max_resistance_cell = 0;
+  uint8_t cells = 0;
+
+  for (uint8_t i = 0; i < ResistanceEstimator::MAX_CELLS; i++) {
+    float resistance = this->resistance_estimator_.get_cell_resistance(i);
+    if (std::isnan(resistance)) {
+      continue;
+    }
+    if (max_resistance_cell == 0 || resistance > max_resistance) {
+      max_resistance = resistance;
+      max_resistance_cell = i + 1;
+    }
+    sum += resistance;
+    cells++;
+  }
+
+  if (cells == 0) {
+    return;
+  }
+
+  this->publish_state_(this->average_cell_internal_resistance_sensor_, (sum / cells) * 1000.0f);
+  this->publish_state_(this->max_cell_internal_resistance_sensor_, max_resistance * 1000.0f);
+  this->publish_state_(this->max_internal_resistance_cell_sensor_, (float) max_resistance_cell);
+}
+
+void BasenBms::decode_balancing_data_(const std::vector<uint8_t> &data) {
+  ESP_LOGI(TAG, "Balancing frame (%u+4 bytes):", (unsigned) data.size());
+  ESP_LOGD(TAG, "  %s", format_hex_pretty(&data.front(), data.size()).c_str());
+
+  if (data.size() < 18) {
+    ESP_LOGW(TAG, "Invalid balancing frame length");
+    return;
+  }
+
+  // Byte Len Payload              Description                      Unit  Precision
+  //  0    1  0x3A                 Start of frame
+  //  1    1  0x16                 Address
+  //  2    1  0xFE                 Frame type
+  //  3    1  0x13                 Data length
+  //  4    1  0x01
+  //  5    1  0x75
+  //  6    1  0x08
+  //  7    1  0x34
+  //  8    1  0x80                 Charging states (Bitmask)
+  //  9    1  0x80                 Discharging states (Bitmask)
+  //  10   1  0x00                 Charging warnings (Bitmask)
+  //  11   1  0x00                 Discharging warnings (Bitmask)
+  //  12   1  0x80
+  //  13   5  0x00 0x00 0x00 0x00 0x00  Balancing cells (Bitmask, cell 1 is the LSB of byte 13, unconfirmed)
+  //  18   1  0x00
+  //  19   1  0x02
+  //  20   1  0x76
+  //  21   1  0x53
+  //  22   1  0x61
+  //  23   1  0x85                 CRC
+  //  24   1  0x04                 CRC
+  //  25   1  0x0D                 End of frame
+  //  26   1  0x0A                 End of frame
+  // The position of the bitmap isn't confirmed by a capture of a balancing pack yet
+  if (!this->balancing_bitmap_) {
+    return;
+  }
+
+  uint64_t balancing_cells = 0;
+  for (uint8_t i = 0; i < 5; i++) {
+    balancing_cells |= uint64_t(data[13 + i]) << (i * 8);
+  }
+  balancing_cells &= (uint64_t(1) << 34) - 1;
+
+  // Push the balancing state on changes only
+  if (this->balancing_cells_published_ && balancing_cells == this->balancing_cells_) {
+    return;
+  }
+  this->balancing_cells_ = balancing_cells;
+  this->balancing_cells_published_ = true;
+
+  uint8_t count = 0;
+  std::string cells = "";
+  for (uint8_t i = 0; i < 34; i++) {
+    if (balancing_cells & (uint64_t(1) << i)) {
+      count++;
+      if (this->balancing_cells_text_sensor_ != nullptr) {
+        cells.append(to_string(i + 1));
+        cells.append(";");
+      }
+    }
+  }
+  if (!cells.empty()) {
+    cells.pop_back();
+  }
+
+  this->publish_state_(this->balancing_binary_sensor_, count > 0);
+  this->publish_state_(this->balancing_cell_count_sensor_, (float) count);
+  this->publish_state_(this->balancing_cells_text_sensor_, cells);
+}
+
+void BasenBms::decode_protect_ic_data_(const std::vector<uint8_t> &data) {
+  ESP_LOGI(TAG, "Protect IC frame (%u+4 bytes):", (unsigned) data.size());
+  ESP_LOGD(TAG, "  %s", format_hex_pretty(&data.front(), data.size()).c_str());
+
+  if (data.size() < 18) {
+    ESP_LOGW(TAG, "Invalid protect IC frame length");
+    return;
+  }
+
+  // The register layout of the protect IC isn't documented. Only temperature 3 and 4 are decoded; the raw
+  // registers are logged at a protection trip for diagnosis
+  if (this->charging_protections_ || this->discharging_protections_) {
+    ESP_LOGI(TAG, "Protect IC registers at protection trip: %s", format_hex_pretty(&data[4], data.size() - 4).c_str());
+  }
+
+  // Byte Len Payload              Description                      Unit  Precision
+  //  0    1  0x3A                 Start of frame
+  //  1    1  0x16                 Address
+  //  2    1  0x27                 Frame type
+  //  3    1                       Data length
+  //  4    1
+  //  5    1
+  //  6    1
+  //  7    1
+  //  8    1
+  //  9    1
+  //  10   1
+  //  11   1
+  //  12   1
+  //  13   1                       Temperature 3 (if SOF is 0x3B)   °C    1.0f
+  //  14   1
+  //  15   1
+  //  16   1
+  //  17   1                       Temperature 4 (if SOF is 0x3B)   °C    1.0f
+  //  18   1
+  //  19   1
+  //  20   1
+  //  21   1
+  //  22   1
+  //  23   1                       CRC
+  //  24   1  0x04                 CRC
+  //  25   1  0x0D                 End of frame
+  //  26   1  0x0A                 End of frame
+  if (data[0] != BASEN_PKT_START_B) {
+    return;
+  }
+
+  const uint8_t temperature_offsets[2] = {13, 17};
+  for (uint8_t i = 0; i < 2; i++) {
+    int8_t temperature = (int8_t) data[temperature_offsets[i]];
+    if (temperature < MIN_TEMPERATURE || temperature > MAX_TEMPERATURE) {
+      ESP_LOGW(TAG, "Temperature %d of the protect IC is out of range: %d", i + 3, temperature);
+      continue;
+    }
+    this->publish_temperature_(i + 2, (float) temperature);
+  }
+}
+
+void BasenBms::dump_config() {  // NOLINT(google-readability-function-size,readability-function-size)
+  // Packs polled over the link of another instance don't have a transport which prints the header
+  if (this->link_ != nullptr) {
+    ESP_LOGCONFIG(TAG, "BasenBms:");
+    ESP_LOGCONFIG(TAG, "  Link: address 0x%02X", this->link_->address_);
+  }
+  ESP_LOGCONFIG(TAG, "  Address: 0x%02X", this->address_);
+  ESP_LOGCONFIG(TAG, "  Fake traffic enabled: %s", YESNO(this->enable_fake_traffic_));
+  ESP_LOGCONFIG(TAG, "  Balancing bitmap (experimental): %s", YESNO(this->balancing_bitmap_));
+  if (this->min_update_interval_ > 0) {
+    ESP_LOGCONFIG(TAG, "  Adaptive polling: %u...%u ms", (unsigned) this->min_update_interval_,
+                  (unsigned) this->max_update_interval_);
+  }
+  if (this->history_.is_initialized()) {
+    ESP_LOGCONFIG(TAG, "  History: %u bytes", (unsigned) this->history_.get_capacity());
+  }
+  for (uint8_t i = 0; i < BASEN_COMMAND_QUEUE_SIZE; i++) {
+    ESP_LOGCONFIG(TAG, "  Request frame 0x%02X: %s", BASEN_COMMAND_QUEUE[i], YESNO(this->requested_frames_ & (1 << i)));
+  }
+
+  LOG_BINARY_SENSOR("", "Balancing", this->balancing_binary_sensor_);
+  LOG_BINARY_SENSOR("", "Charging", this->charging_binary_sensor_);
+  LOG_BINARY_SENSOR("", "Discharging", this->discharging_binary_sensor_);
+
+  LOG_SENSOR("", "Total voltage", this->total_voltage_sensor_);
+  LOG_SENSOR("", "Current", this->current_sensor_);
+  LOG_SENSOR("", "Power", this->power_sensor_);
+  LOG_SENSOR("", "Charging power", this->charging_power_sensor_);
+  LOG_SENSOR("", "Discharging power", this->discharging_power_sensor_);
+  LOG_SENSOR("", "Capacity remaining", this->capacity_remaining_sensor_);
+  LOG_SENSOR("", "Charging states bitmask", this->charging_states_bitmask_sensor_);
+  LOG_SENSOR("", "Discharging states bitmask", this->discharging_states_bitmask_sensor_);
+  LOG_SENSOR("", "Charging warnings bitmask", this->charging_warnings_bitmask_sensor_);
+  LOG_SENSOR("", "Discharging warnings bitmask", this->discharging_warnings_bitmask_sensor_);
+  LOG_SENSOR("", "State of charge", this->state_of_charge_sensor_);
+  LOG_SENSOR("", "Nominal capacity", this->nominal_capacity_sensor_);
+  LOG_SENSOR("", "Nominal voltage", this->nominal_voltage_sensor_);
+  LOG_SENSOR("", "Real capacity", this->real_capacity_sensor_);
+  LOG_SENSOR("", "Serial number", this->serial_number_sensor_);
+  LOG_SENSOR("", "Charging cycles", this->charging_cycles_sensor_);
+  LOG_SENSOR("", "Min cell voltage", this->min_cell_voltage_sensor_);
+  LOG_SENSOR("", "Max cell voltage", this->max_cell_voltage_sensor_);
+  LOG_SENSOR("", "Min voltage cell", this->min_voltage_cell_sensor_);
+  LOG_SENSOR("", "Max voltage cell", this->max_voltage_cell_sensor_);
+  LOG_SENSOR("", "Delta cell voltage", this->delta_cell_voltage_sensor_);
+  LOG_SENSOR("", "Average cell voltage", this->average_cell_voltage_sensor_);
+  LOG_SENSOR("", "Balancing cell count", this->balancing_cell_count_sensor_);
+  LOG_SENSOR("", "Max cell deviation", this->max_cell_deviation_sensor_);
+  LOG_SENSOR("", "Max deviation cell", this->max_deviation_cell_sensor_);
+  LOG_SENSOR("", "Max cell drift rate", this->max_cell_drift_rate_sensor_);
+  LOG_SENSOR("", "Max drift cell", this->max_drift_cell_sensor_);
+  LOG_SENSOR("", "Rolling min cell voltage", this->rolling_min_cell_voltage_sensor_);
+  LOG_SENSOR("", "Rolling max cell voltage", this->rolling_max_cell_voltage_sensor_);
+  LOG_SENSOR("", "Internal resistance", this->internal_resistance_sensor_);
+  LOG_SENSOR("", "Average cell internal resistance", this->average_cell_internal_resistance_sensor_);
+  LOG_SENSOR("", "Max cell internal resistance", this->max_cell_internal_resistance_sensor_);
+  LOG_SENSOR("", "Max internal resistance cell", this->max_internal_resistance_cell_sensor_);
+  LOG_SENSOR("", "Effective update interval", this->effective_update_interval_sensor_);
+  LOG_SENSOR("", "Wake to data time", this->wake_to_data_time_sensor_);
+  LOG_SENSOR("", "Duty cycle", this->duty_cycle_sensor_);
+  LOG_SENSOR("", "Frame queue depth", this->frame_queue_depth_sensor_);
+  LOG_SENSOR("", "Dropped frames", this->dropped_frames_sensor_);
+  LOG_SENSOR("", "Temperature 1", this->temperatures_[0].temperature_sensor_);
+  LOG_SENSOR("", "Temperature 2", this->temperatures_[1].temperature_sensor_);
+  LOG_SENSOR("", "Temperature 3", this->temperatures_[2].temperature_sensor_);
+  LOG_SENSOR("", "Temperature 4", this->temperatures_[3].temperature_sensor_);
+  LOG_SENSOR("", "Cell Voltage 1", this->cells_[0].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 2", this->cells_[1].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 3", this->cells_[2].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 4", this->cells_[3].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 5", this->cells_[4].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 6", this->cells_[5].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 7", this->cells_[6].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 8", this->cells_[7].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 9", this->cells_[8].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 10", this->cells_[9].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 11", this->cells_[10].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 12", this->cells_[11].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 13", this->cells_[12].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 14", this->cells_[13].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 15", this->cells_[14].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 16", this->cells_[15].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 17", this->cells_[16].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 18", this->cells_[17].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 19", this->cells_[18].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 20", this->cells_[19].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 21", this->cells_[20].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 22", this->cells_[21].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 23", this->cells_[22].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 24", this->cells_[23].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 25", this->cells_[24].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 26", this->cells_[25].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 27", this->cells_[26].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 28", this->cells_[27].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 29", this->cells_[28].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 30", this->cells_[29].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 31", this->cells_[30].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 32", this->cells_[31].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 33", this->cells_[32].cell_voltage_sensor_);
+  LOG_SENSOR("", "Cell Voltage 34", this->cells_[33].cell_voltage_sensor_);
+
+  LOG_TEXT_SENSOR("", "Charging states", this->charging_states_text_sensor_);
+  LOG_TEXT_SENSOR("", "Discharging states", this->discharging_states_text_sensor_);
+  LOG_TEXT_SENSOR("", "Charging warnings", this->charging_warnings_text_sensor_);
+  LOG_TEXT_SENSOR("", "Discharging warnings", this->discharging_warnings_text_sensor_);
+  LOG_TEXT_SENSOR("", "Balancing cells", this->balancing_cells_text_sensor_);
+  LOG_TEXT_SENSOR("", "Protection faults", this->protection_faults_text_sensor_);
+}
+
+void BasenBms::publish_state_(binary_sensor::BinarySensor *binary_sensor, const bool &state) {
+  if (binary_sensor == nullptr)
+    return;
+
+  binary_sensor->publish_state(state);
+}
+
+void BasenBms::publish_state_(sensor::Sensor *sensor, float value) {
+  if (sensor == nullptr)
+    return;
+
+  sensor->publish_state(value);
+}
+
+void BasenBms::publish_state_(text_sensor::TextSensor *text_sensor, const std::string &state) {
+  if (text_sensor == nullptr)
+    return;
+
+  text_sensor->publish_state(state);
+}
+
+void BasenBms::publish_state_(switch_::Switch *obj, const bool &state) {
+  if (obj == nullptr)
+    return;
+
+  obj->publish_state(state);
+}
+
+void BasenBms::write_register(uint8_t address, uint16_t value) {
+  // this->send_command_(BASEN_CMD_WRITE, BASEN_CMD_MOS);  // @TODO: Pass value
+  (void) address;
+  (void) value;
+}
+
+bool BasenBms::send_command_(uint8_t start_of_frame, uint8_t function, uint8_t value) {
+  uint8_t frame[9];
+  uint8_t data_len = 1;
+
+  frame[0] = start_of_frame;
+  frame[1] = this->address_;
+  frame[2] = function;
+  frame[3] = data_len;
+  frame[4] = value;
+  auto crc = chksum_(frame + 1, 4);
+  frame[5] = crc >> 0;
+  frame[6] = crc >> 8;
+  frame[7] = BASEN_PKT_END_1;
+  frame[8] = BASEN_PKT_END_2;
+
+  ESP_LOGV(TAG, "Send command: %s", format_hex_pretty(frame, sizeof(frame)).c_str());
+
+  if (this->enable_fake_traffic_) {
+    this->inject_fake_traffic_(function);
+    return true;
+  }
+
+  return this->write_frame_(frame, sizeof(frame));
+}
+
+void BasenBms::inject_fake_traffic_(uint8_t frame_type) {
+  // Current -6909 mAh
+  const uint8_t status_frame[32] = {0x3a, 0x16, 0x2a, 0x18, 0x03, 0xe5, 0xff, 0xff, 0x06, 0x64, 0x00,
+                                    0x00, 0x12, 0x14, 0x19, 0x19, 0x35, 0x3d, 0x00, 0x00, 0x80, 0x80,
+                                    0x00, 0x00, 0x0e, 0x02, 0x00, 0x00, 0x82, 0x05, 0x0d, 0x0a};
+  const uint8_t general_info_frame[32] = {0x3a, 0x16, 0x2b, 0x18, 0xa0, 0x86, 0x01, 0x00, 0x00, 0x64, 0x00,
+                                          0x00, 0x91, 0xa0, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x30, 0x75,
+                                          0x00, 0x00, 0x71, 0x53, 0x07, 0x00, 0x86, 0x04, 0x0d, 0x0a};
+  const uint8_t cell_voltages_frame[32] = {0x3a, 0x16, 0x24, 0x18, 0x96, 0x0c, 0x97, 0x0c, 0x98, 0x0c, 0x96,
+                                           0x0c, 0x96, 0x0c, 0x98, 0x0c, 0x98, 0x0c, 0x97, 0x0c, 0x00, 0x00,
+                                           0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x6a, 0x05, 0x0d, 0x0a};
+  const uint8_t cell_voltages_frame2[32] = {0x3a, 0x16, 0x25, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x53, 0x00, 0x0d, 0x0a};
+  const uint8_t cell_voltages_frame3[28] = {0x3a, 0x16, 0x26, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                            0x00, 0x00, 0x00, 0x00, 0x50, 0x00, 0x0d, 0x0a};
+  const uint8_t balancing_frame[27] = {0x3a, 0x16, 0xfe, 0x13, 0x00, 0xf9, 0x0f, 0x2c, 0x80,
+                                       0x80, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                       0x00, 0x02, 0x76, 0x53, 0x61, 0x07, 0x05, 0x0d, 0x0a};
+
+  switch (frame_type) {
+    case BASEN_FRAME_TYPE_STATUS:
+      this->inject_frame_(status_frame, sizeof(status_frame));
+      break;
+    case BASEN_FRAME_TYPE_GENERAL_INFO:
+      this->inject_frame_(general_info_frame, sizeof(general_info_frame));
+      break;
+    case BASEN_FRAME_TYPE_CELL_VOLTAGES_1_12:
+      this->inject_frame_(cell_voltages_frame, sizeof(cell_voltages_frame));
+      break;
+    case BASEN_FRAME_TYPE_CELL_VOLTAGES_13_24:
+      this->inject_frame_(cell_voltages_frame2, sizeof(cell_voltages_frame2));
+      break;
+    case BASEN_FRAME_TYPE_CELL_VOLTAGES_25_34:
+      this->inject_frame_(cell_voltages_frame3, sizeof(cell_voltages_frame3));
+      break;
+    case BASEN_FRAME_TYPE_BALANCING:
+      this->inject_frame_(balancing_frame, sizeof(balancing_frame));
+      break;
+    default:
+      ESP_LOGW(TAG, "Unhandled request received: 0x%02X", frame_type);
+  }
+}
+
+void BasenBms::inject_frame_(const uint8_t *frame, uint16_t length) {
+  // The recorded frames are addressed to the default address
+  std::vector<uint8_t> buffer(frame, frame + length);
+  buffer[1] = this->address_;
+  uint16_t crc = chksum_(&buffer[1], buffer[3] + 3);
+  buffer[length - 4] = crc >> 0;
+  buffer[length - 3] = crc >> 8;
+
+  this->get_link_()->assemble_(buffer.data(), length);
+}
+
+std::string BasenBms::charging_states_bits_to_string_(const uint8_t mask) {
+  std::string values = "";
+  if (mask) {
+    for (int i = 0; i < CHARGING_STATES_SIZE; i++) {
+      if (mask & (1 << i)) {
+        values.append(CHARGING_STATES[i]);
+        values.append(";");
+      }
+    }
+    if (!values.empty()) {
+      values.pop_back();
+    }
+  }
+  return values;
+}
+
+std::string BasenBms::discharging_states_bits_to_string_(const uint8_t mask) {
+  std::string values = "";
+  if (mask) {
+    for (int i = 0; i < DISCHARGING_STATES_SIZE; i++) {
+      if (mask & (1 << i)) {
+        values.append(DISCHARGING_STATES[i]);
+        values.append(";");
+      }
+    }
+    if (!values.empty()) {
+      values.pop_back();
+    }
+  }
+  return values;
+}
+
+std::string BasenBms::charging_warnings_bits_to_string_(const uint8_t mask) {
+  std::string values = "";
+  if (mask) {
+    for (int i = 0; i < CHARGING_WARNINGS_SIZE; i++) {
+      if (mask & (1 << i)) {
+        values.append(CHARGING_WARNINGS[i]);
+        values.append(";");
+      }
+    }
+    if (!values.empty()) {
+      values.pop_back();
+    }
+  }
+  return values;
+}
+
+std::string BasenBms::discharging_warnings_bits_to_string_(const uint8_t mask) {
+  std::string values = "";
+  if (mask) {
+    for (int i = 0; i < DISCHARGING_WARNINGS_SIZE; i++) {
+      if (mask & (1 << i)) {
+        values.append(DISCHARGING_WARNINGS[i]);
+        values.append(";");
+      }
+    }
+    if (!values.empty()) {
+      values.pop_back();
+    }
+  }
+  return values;
+}
+
+}  // namespace basen_bms_ble
+}  // namespace esphome
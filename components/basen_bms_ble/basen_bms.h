@@ -0,0 +1,423 @@
+#pragma once
+
+#include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+#include "esphome/components/binary_sensor/binary_sensor.h"
+#include "esphome/components/sensor/sensor.h"
+#include "esphome/components/switch/switch.h"
+#include "esphome/components/text_sensor/text_sensor.h"
+#include "cell_statistics.h"
+#include "frame_queue.h"
+#include "history_store.h"
+#include "pack_state.h"
+#include "resistance_estimator.h"
+
+namespace esphome {
+namespace basen_bms_ble {
+
+static const uint8_t BASEN_PKT_START_A = 0x3A;
+static const uint8_t BASEN_PKT_START_B = 0x3B;
+static const uint8_t BASEN_DEFAULT_ADDRESS = 0x16;
+static const uint8_t BASEN_PKT_END_1 = 0x0D;
+static const uint8_t BASEN_PKT_END_2 = 0x0A;
+
+static const uint8_t BASEN_FRAME_TYPE_CELL_VOLTAGES_1_12 = 0x24;
+static const uint8_t BASEN_FRAME_TYPE_CELL_VOLTAGES_13_24 = 0x25;
+static const uint8_t BASEN_FRAME_TYPE_CELL_VOLTAGES_25_34 = 0x26;
+static const uint8_t BASEN_FRAME_TYPE_PROTECT_IC = 0x27;
+static const uint8_t BASEN_FRAME_TYPE_STATUS = 0x2A;
+static const uint8_t BASEN_FRAME_TYPE_GENERAL_INFO = 0x2B;
+static const uint8_t BASEN_FRAME_TYPE_SETTINGS = 0xE8;
+static const uint8_t BASEN_FRAME_TYPE_SETTINGS_ALTERNATIVE = 0xEA;
+static const uint8_t BASEN_FRAME_TYPE_BALANCING = 0xFE;
+
+static const uint16_t MAX_RESPONSE_SIZE = 42 + 2;
+
+// Channels of the history records
+static const uint8_t HISTORY_TOTAL_VOLTAGE = 0;       // mV
+static const uint8_t HISTORY_CURRENT = 1;             // 10 mA
+static const uint8_t HISTORY_CAPACITY_REMAINING = 2;  // mAh
+static const uint8_t HISTORY_STATE_OF_CHARGE = 3;     // %
+static const uint8_t HISTORY_STATE_MASKS = 4;         // Charging/discharging states and warnings (bytes 20...23)
+static const uint8_t HISTORY_TEMPERATURE_1 = 5;       // °C, 4 channels
+static const uint8_t HISTORY_CELL_VOLTAGE_1 = 9;      // mV, one channel per available cell
+
+// Protocol core (command scheduler, frame validation and decoders) shared by all transports
+class BasenBms : public PollingComponent {
+ public:
+  void setup() override;
+  void dump_config() override;
+  void loop() override;
+  void update() override;
+  float get_setup_priority() const override { return setup_priority::DATA; }
+
+  void set_balancing_binary_sensor(binary_sensor::BinarySensor *balancing_binary_sensor) {
+    balancing_binary_sensor_ = balancing_binary_sensor;
+  }
+  void set_charging_binary_sensor(binary_sensor::BinarySensor *charging_binary_sensor) {
+    charging_binary_sensor_ = charging_binary_sensor;
+  }
+  void set_discharging_binary_sensor(binary_sensor::BinarySensor *discharging_binary_sensor) {
+    discharging_binary_sensor_ = discharging_binary_sensor;
+  }
+
+  void set_total_voltage_sensor(sensor::Sensor *total_voltage_sensor) { total_voltage_sensor_ = total_voltage_sensor; }
+  void set_current_sensor(sensor::Sensor *current_sensor) { current_sensor_ = current_sensor; }
+  void set_power_sensor(sensor::Sensor *power_sensor) { power_sensor_ = power_sensor; }
+  void set_charging_power_sensor(sensor::Sensor *charging_power_sensor) {
+    charging_power_sensor_ = charging_power_sensor;
+  }
+  void set_discharging_power_sensor(sensor::Sensor *discharging_power_sensor) {
+    discharging_power_sensor_ = discharging_power_sensor;
+  }
+  void set_capacity_remaining_sensor(sensor::Sensor *capacity_remaining_sensor) {
+    capacity_remaining_sensor_ = capacity_remaining_sensor;
+  }
+  void set_charging_states_bitmask_sensor(sensor::Sensor *charging_states_bitmask_sensor) {
+    charging_states_bitmask_sensor_ = charging_states_bitmask_sensor;
+  }
+  void set_discharging_states_bitmask_sensor(sensor::Sensor *discharging_states_bitmask_sensor) {
+    discharging_states_bitmask_sensor_ = discharging_states_bitmask_sensor;
+  }
+  void set_charging_warnings_bitmask_sensor(sensor::Sensor *charging_warnings_bitmask_sensor) {
+    charging_warnings_bitmask_sensor_ = charging_warnings_bitmask_sensor;
+  }
+  void set_discharging_warnings_bitmask_sensor(sensor::Sensor *discharging_warnings_bitmask_sensor) {
+    discharging_warnings_bitmask_sensor_ = discharging_warnings_bitmask_sensor;
+  }
+  void set_state_of_charge_sensor(sensor::Sensor *state_of_charge_sensor) {
+    state_of_charge_sensor_ = state_of_charge_sensor;
+  }
+  void set_nominal_capacity_sensor(sensor::Sensor *nominal_capacity_sensor) {
+    nominal_capacity_sensor_ = nominal_capacity_sensor;
+  }
+  void set_nominal_voltage_sensor(sensor::Sensor *nominal_voltage_sensor) {
+    nominal_voltage_sensor_ = nominal_voltage_sensor;
+  }
+  void set_real_capacity_sensor(sensor::Sensor *real_capacity_sensor) { real_capacity_sensor_ = real_capacity_sensor; }
+  void set_serial_number_sensor(sensor::Sensor *serial_number_sensor) { serial_number_sensor_ = serial_number_sensor; }
+  void set_charging_cycles_sensor(sensor::Sensor *charging_cycles_sensor) {
+    charging_cycles_sensor_ = charging_cycles_sensor;
+  }
+
+  void set_min_cell_voltage_sensor(sensor::Sensor *min_cell_voltage_sensor) {
+    min_cell_voltage_sensor_ = min_cell_voltage_sensor;
+  }
+  void set_max_cell_voltage_sensor(sensor::Sensor *max_cell_voltage_sensor) {
+    max_cell_voltage_sensor_ = max_cell_voltage_sensor;
+  }
+  void set_min_voltage_cell_sensor(sensor::Sensor *min_voltage_cell_sensor) {
+    min_voltage_cell_sensor_ = min_voltage_cell_sensor;
+  }
+  void set_max_voltage_cell_sensor(sensor::Sensor *max_voltage_cell_sensor) {
+    max_voltage_cell_sensor_ = max_voltage_cell_sensor;
+  }
+  void set_delta_cell_voltage_sensor(sensor::Sensor *delta_cell_voltage_sensor) {
+    delta_cell_voltage_sensor_ = delta_cell_voltage_sensor;
+  }
+  void set_average_cell_voltage_sensor(sensor::Sensor *average_cell_voltage_sensor) {
+    average_cell_voltage_sensor_ = average_cell_voltage_sensor;
+  }
+  void set_max_cell_deviation_sensor(sensor::Sensor *max_cell_deviation_sensor) {
+    max_cell_deviation_sensor_ = max_cell_deviation_sensor;
+  }
+  void set_max_deviation_cell_sensor(sensor::Sensor *max_deviation_cell_sensor) {
+    max_deviation_cell_sensor_ = max_deviation_cell_sensor;
+  }
+  void set_max_cell_drift_rate_sensor(sensor::Sensor *max_cell_drift_rate_sensor) {
+    max_cell_drift_rate_sensor_ = max_cell_drift_rate_sensor;
+  }
+  void set_max_drift_cell_sensor(sensor::Sensor *max_drift_cell_sensor) {
+    max_drift_cell_sensor_ = max_drift_cell_sensor;
+  }
+  void set_rolling_min_cell_voltage_sensor(sensor::Sensor *rolling_min_cell_voltage_sensor) {
+    rolling_min_cell_voltage_sensor_ = rolling_min_cell_voltage_sensor;
+  }
+  void set_rolling_max_cell_voltage_sensor(sensor::Sensor *rolling_max_cell_voltage_sensor) {
+    rolling_max_cell_voltage_sensor_ = rolling_max_cell_voltage_sensor;
+  }
+  void set_internal_resistance_sensor(sensor::Sensor *internal_resistance_sensor) {
+    internal_resistance_sensor_ = internal_resistance_sensor;
+  }
+  void set_average_cell_internal_resistance_sensor(sensor::Sensor *average_cell_internal_resistance_sensor) {
+    average_cell_internal_resistance_sensor_ = average_cell_internal_resistance_sensor;
+  }
+  void set_max_cell_internal_resistance_sensor(sensor::Sensor *max_cell_internal_resistance_sensor) {
+    max_cell_internal_resistance_sensor_ = max_cell_internal_resistance_sensor;
+  }
+  void set_max_internal_resistance_cell_sensor(sensor::Sensor *max_internal_resistance_cell_sensor) {
+    max_internal_resistance_cell_sensor_ = max_internal_resistance_cell_sensor;
+  }
+  void set_balancing_cell_count_sensor(sensor::Sensor *balancing_cell_count_sensor) {
+    balancing_cell_count_sensor_ = balancing_cell_count_sensor;
+  }
+  void set_effective_update_interval_sensor(sensor::Sensor *effective_update_interval_sensor) {
+    effective_update_interval_sensor_ = effective_update_interval_sensor;
+  }
+  void set_wake_to_data_time_sensor(sensor::Sensor *wake_to_data_time_sensor) {
+    wake_to_data_time_sensor_ = wake_to_data_time_sensor;
+  }
+  void set_duty_cycle_sensor(sensor::Sensor *duty_cycle_sensor) { duty_cycle_sensor_ = duty_cycle_sensor; }
+  void set_frame_queue_depth_sensor(sensor::Sensor *frame_queue_depth_sensor) {
+    frame_queue_depth_sensor_ = frame_queue_depth_sensor;
+  }
+  void set_dropped_frames_sensor(sensor::Sensor *dropped_frames_sensor) {
+    dropped_frames_sensor_ = dropped_frames_sensor;
+  }
+  void set_cell_voltage_sensor(uint8_t cell, sensor::Sensor *cell_voltage_sensor) {
+    this->cells_[cell].cell_voltage_sensor_ = cell_voltage_sensor;
+  }
+  void set_temperature_sensor(uint8_t temperature, sensor::Sensor *temperature_sensor) {
+    this->temperatures_[temperature].temperature_sensor_ = temperature_sensor;
+  }
+
+  void set_charging_switch(switch_::Switch *charging_switch) { charging_switch_ = charging_switch; }
+  void set_discharging_switch(switch_::Switch *discharging_switch) { discharging_switch_ = discharging_switch; }
+
+  void set_charging_states_text_sensor(text_sensor::TextSensor *charging_states_text_sensor) {
+    charging_states_text_sensor_ = charging_states_text_sensor;
+  }
+  void set_discharging_states_text_sensor(text_sensor::TextSensor *discharging_states_text_sensor) {
+    discharging_states_text_sensor_ = discharging_states_text_sensor;
+  }
+  void set_charging_warnings_text_sensor(text_sensor::TextSensor *charging_warnings_text_sensor) {
+    charging_warnings_text_sensor_ = charging_warnings_text_sensor;
+  }
+  void set_discharging_warnings_text_sensor(text_sensor::TextSensor *discharging_warnings_text_sensor) {
+    discharging_warnings_text_sensor_ = discharging_warnings_text_sensor;
+  }
+  void set_manufacturing_date_text_sensor(text_sensor::TextSensor *manufacturing_date_text_sensor) {
+    manufacturing_date_text_sensor_ = manufacturing_date_text_sensor;
+  }
+  void set_balancing_cells_text_sensor(text_sensor::TextSensor *balancing_cells_text_sensor) {
+    balancing_cells_text_sensor_ = balancing_cells_text_sensor;
+  }
+  void set_protection_faults_text_sensor(text_sensor::TextSensor *protection_faults_text_sensor) {
+    protection_faults_text_sensor_ = protection_faults_text_sensor;
+  }
+
+  void set_enable_fake_traffic(bool enable_fake_traffic) { enable_fake_traffic_ = enable_fake_traffic; }
+  void set_balancing_bitmap(bool balancing_bitmap) { balancing_bitmap_ = balancing_bitmap; }
+  void set_cell_statistics_window(uint32_t cell_statistics_window) {
+    this->cell_statistics_.set_window(cell_statistics_window);
+  }
+  void set_cell_statistics_smoothing(float cell_statistics_smoothing) {
+    this->cell_statistics_.set_smoothing(cell_statistics_smoothing);
+  }
+  void set_internal_resistance_current_step(float internal_resistance_current_step) {
+    this->resistance_estimator_.set_min_current_step(internal_resistance_current_step);
+  }
+  void set_adaptive_polling(uint32_t min_update_interval, uint32_t max_update_interval, float current_threshold,
+                            float voltage_rate_threshold) {
+    this->min_update_interval_ = min_update_interval;
+    this->max_update_interval_ = max_update_interval;
+    this->activity_current_threshold_ = current_threshold;
+    this->activity_voltage_rate_threshold_ = voltage_rate_threshold;
+  }
+  void set_address(uint8_t address) { this->address_ = address; }
+  uint8_t get_address() const { return this->address_; }
+  // Size of the compressed history ring in bytes (PSRAM if available), 0 disables the history
+  void set_history_size(size_t history_size) { this->history_size_ = history_size; }
+  // Calls the reader with the history locked against the appends of loop(), e.g. from the web server task
+  void read_history(const std::function<void(const HistoryStore &)> &reader) {
+    LockGuard guard(this->history_lock_);
+    reader(this->history_);
+  }
+  // Latest decoded values and metrics of the pack, independent of the configured entities
+  const PackState &get_state();
+  // Poll this pack over the link of another instance (paralleled packs behind one connection)
+  void set_link(BasenBms *link) {
+    this->link_ = link;
+    link->packs_.push_back(this);
+  }
+  // Cell voltage chunks beyond a known number of cells aren't requested (0 = unknown)
+  void set_cell_count_hint(uint8_t cell_count_hint) { this->cell_count_hint_ = cell_count_hint; }
+  uint8_t get_cell_count() const { return this->cell_count_; }
+  void request_frame(uint8_t frame_type);
+  void write_register(uint8_t address, uint16_t value);
+
+  void add_on_cell_voltage_callback(std::function<void(uint8_t, float)> &&callback) {
+    this->cell_voltage_callback_.add(std::move(callback));
+  }
+  void add_on_temperature_callback(std::function<void(uint8_t, float)> &&callback) {
+    this->temperature_callback_.add(std::move(callback));
+  }
+  void add_on_delta_cell_voltage_callback(std::function<void(float)> &&callback) {
+    this->delta_cell_voltage_callback_.add(std::move(callback));
+  }
+  void add_on_warning_raised_callback(std::function<void(const std::string &)> &&callback) {
+    this->warning_raised_callback_.add(std::move(callback));
+  }
+
+ protected:
+  binary_sensor::BinarySensor *balancing_binary_sensor_;
+  binary_sensor::BinarySensor *charging_binary_sensor_;
+  binary_sensor::BinarySensor *discharging_binary_sensor_;
+
+  sensor::Sensor *total_voltage_sensor_;
+  sensor::Sensor *current_sensor_;
+  sensor::Sensor *power_sensor_;
+  sensor::Sensor *charging_power_sensor_;
+  sensor::Sensor *discharging_power_sensor_;
+  sensor::Sensor *capacity_remaining_sensor_;
+  sensor::Sensor *charging_states_bitmask_sensor_;
+  sensor::Sensor *discharging_states_bitmask_sensor_;
+  sensor::Sensor *charging_warnings_bitmask_sensor_;
+  sensor::Sensor *discharging_warnings_bitmask_sensor_;
+  sensor::Sensor *state_of_charge_sensor_;
+  sensor::Sensor *nominal_capacity_sensor_;
+  sensor::Sensor *nominal_voltage_sensor_;
+  sensor::Sensor *real_capacity_sensor_;
+  sensor::Sensor *serial_number_sensor_;
+  sensor::Sensor *charging_cycles_sensor_;
+  sensor::Sensor *min_cell_voltage_sensor_;
+  sensor::Sensor *max_cell_voltage_sensor_;
+  sensor::Sensor *min_voltage_cell_sensor_;
+  sensor::Sensor *max_voltage_cell_sensor_;
+  sensor::Sensor *delta_cell_voltage_sensor_;
+  sensor::Sensor *average_cell_voltage_sensor_;
+  sensor::Sensor *max_cell_deviation_sensor_;
+  sensor::Sensor *max_deviation_cell_sensor_;
+  sensor::Sensor *max_cell_drift_rate_sensor_;
+  sensor::Sensor *max_drift_cell_sensor_;
+  sensor::Sensor *rolling_min_cell_voltage_sensor_;
+  sensor::Sensor *rolling_max_cell_voltage_sensor_;
+  sensor::Sensor *internal_resistance_sensor_;
+  sensor::Sensor *average_cell_internal_resistance_sensor_;
+  sensor::Sensor *max_cell_internal_resistance_sensor_;
+  sensor::Sensor *max_internal_resistance_cell_sensor_;
+  sensor::Sensor *balancing_cell_count_sensor_;
+  sensor::Sensor *effective_update_interval_sensor_;
+  sensor::Sensor *wake_to_data_time_sensor_;
+  sensor::Sensor *duty_cycle_sensor_;
+  sensor::Sensor *frame_queue_depth_sensor_;
+  sensor::Sensor *dropped_frames_sensor_;
+
+  switch_::Switch *charging_switch_;
+  switch_::Switch *discharging_switch_;
+
+  text_sensor::TextSensor *charging_states_text_sensor_;
+  text_sensor::TextSensor *discharging_states_text_sensor_;
+  text_sensor::TextSensor *charging_warnings_text_sensor_;
+  text_sensor::TextSensor *discharging_warnings_text_sensor_;
+  text_sensor::TextSensor *manufacturing_date_text_sensor_;
+  text_sensor::TextSensor *balancing_cells_text_sensor_;
+  text_sensor::TextSensor *protection_faults_text_sensor_;
+
+  struct Cell {
+    sensor::Sensor *cell_voltage_sensor_{nullptr};
+  } cells_[34];
+
+  struct Temperature {
+    sensor::Sensor *temperature_sensor_{nullptr};
+  } temperatures_[4];
+
+  uint8_t address_{BASEN_DEFAULT_ADDRESS};
+  // Link owner and the packs polled over its link in round-robin order (the owner is the first pack)
+  BasenBms *link_{nullptr};
+  std::vector<BasenBms *> packs_{this};
+  BasenBms *active_pack_{nullptr};
+  uint8_t next_pack_{0};
+  uint32_t last_command_timestamp_{0};
+  // A command of the link scheduler awaits its response
+  bool response_pending_{false};
+  bool poll_pending_{false};
+
+  std::vector<uint8_t> frame_buffer_;
+  // Validated frames (without CRC and end of frame) waiting to be decoded in loop()
+  FrameQueue<8, 40> frame_queue_;
+  std::vector<uint8_t> decode_buffer_;
+  uint8_t next_command_{UINT8_MAX};
+  uint8_t requested_frames_{0};
+  bool enable_fake_traffic_;
+
+  uint16_t cell_voltages_[34]{};
+  uint8_t cell_count_{0};
+  uint8_t cell_count_hint_{0};
+  // Experimental: the offset of the balancing bitmap is unconfirmed
+  bool balancing_bitmap_{false};
+  uint64_t balancing_cells_{0};
+  bool balancing_cells_published_{false};
+  uint8_t charging_protections_{0};
+  uint8_t discharging_protections_{0};
+  bool protections_published_{false};
+  bool protect_ic_due_{false};
+  uint8_t charging_warnings_{0};
+  uint8_t discharging_warnings_{0};
+
+  // Adaptive polling is disabled if the min update interval is zero
+  uint32_t min_update_interval_{0};
+  uint32_t max_update_interval_{0};
+  float activity_current_threshold_{1.0f};
+  float activity_voltage_rate_threshold_{0.001f};
+  float last_total_voltage_{NAN};
+  uint32_t last_status_timestamp_{0};
+  uint32_t last_state_masks_{0};
+
+  CallbackManager<void(uint8_t, float)> cell_voltage_callback_{};
+  CallbackManager<void(uint8_t, float)> temperature_callback_{};
+  CallbackManager<void(float)> delta_cell_voltage_callback_{};
+  CallbackManager<void(const std::string &)> warning_raised_callback_{};
+  CellStatistics cell_statistics_;
+  ResistanceEstimator resistance_estimator_;
+  HistoryStore history_;
+  Mutex history_lock_;
+  PackState state_;
+  HistoryStore::Record history_record_;
+  size_t history_size_{0};
+
+  // Transport interface, a pack without its own transport uses the link
+  virtual bool write_frame_(const uint8_t *frame, uint16_t length) {
+    return this->link_ != nullptr && this->link_->write_frame_(frame, length);
+  }
+  virtual bool is_connected_() { return this->link_ != nullptr && this->link_->is_connected_(); }
+
+  BasenBms *get_link_() { return this->link_ != nullptr ? this->link_ : this; }
+  BasenBms *find_pack_(uint8_t address);
+  void discard_frame_();
+  void update_protect_ic_due_(const uint8_t *status);
+  void schedule_poll_(BasenBms *pack);
+  void send_next_link_command_();
+
+  void assemble_(const uint8_t *data, uint16_t length);
+  void on_basen_bms_data_(const std::vector<uint8_t> &data);
+  void decode_status_data_(const std::vector<uint8_t> &data);
+  void decode_general_info_data_(const std::vector<uint8_t> &data);
+  void decode_cell_voltages_data_(const std::vector<uint8_t> &data);
+  void decode_balancing_data_(const std::vector<uint8_t> &data);
+  void decode_protect_ic_data_(const std::vector<uint8_t> &data);
+  void publish_cell_voltage_aggregates_();
+  void publish_cell_statistics_();
+  void record_history_();
+  void publish_cell_internal_resistances_();
+  void publish_temperature_(uint8_t temperature, float value);
+  void check_warnings_(uint8_t charging_warnings, uint8_t discharging_warnings);
+  void adapt_update_interval_(float current, float total_voltage, uint32_t state_masks);
+  void publish_state_(binary_sensor::BinarySensor *binary_sensor, const bool &state);
+  void publish_state_(sensor::Sensor *sensor, float value);
+  void publish_state_(text_sensor::TextSensor *text_sensor, const std::string &state);
+  void publish_state_(switch_::Switch *obj, const bool &state);
+  void inject_fake_traffic_(uint8_t frame_type);
+  void inject_frame_(const uint8_t *frame, uint16_t length);
+  bool send_command_(uint8_t start_of_frame, uint8_t function, uint8_t value = 0x00);
+  bool send_next_command_();
+  bool is_command_queue_pending_();
+  bool is_frame_requested_(uint8_t frame_type);
+  bool is_frame_due_(uint8_t frame_type);
+  bool is_link_idle_();
+  std::string charging_states_bits_to_string_(uint8_t mask);
+  std::string discharging_states_bits_to_string_(uint8_t mask);
+  std::string charging_warnings_bits_to_string_(uint8_t mask);
+  std::string discharging_warnings_bits_to_string_(uint8_t mask);
+
+  uint16_t chksum_(const uint8_t data[], const uint16_t len) {
+    uint16_t checksum = 0x00;
+    for (uint16_t i = 0; i < len; i++) {
+      checksum = checksum + data[i];
+    }
+    return checksum;
+  }
+};
+
+}  // namespace basen_bms_ble
+}  // namespace esphome
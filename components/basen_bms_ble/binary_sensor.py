@@ -3,7 +3,14 @@ from esphome.components import binary_sensor
 import esphome.config_validation as cv
 from esphome.const import CONF_ID
 
-from . import CONF_BASEN_BMS_BLE_ID, BasenBmsBle
+from . import (
+    CONF_BASEN_BMS_BLE_ID,
+    FRAME_TYPE_BALANCING,
+    FRAME_TYPE_STATUS,
+    BasenBms,
+    final_validate_balancing_bitmap,
+    request_frames,
+)
 
 DEPENDENCIES = ["basen_bms_ble"]
 
@@ -13,15 +20,15 @@ CONF_BALANCING = "balancing"
 CONF_CHARGING = "charging"
 CONF_DISCHARGING = "discharging"
 
-BINARY_SENSORS = [
-    CONF_BALANCING,
-    CONF_CHARGING,
-    CONF_DISCHARGING,
-]
+BINARY_SENSORS = {
+    CONF_BALANCING: [FRAME_TYPE_BALANCING],
+    CONF_CHARGING: [FRAME_TYPE_STATUS],
+    CONF_DISCHARGING: [FRAME_TYPE_STATUS],
+}
 
 CONFIG_SCHEMA = cv.Schema(
     {
-        cv.GenerateID(CONF_BASEN_BMS_BLE_ID): cv.use_id(BasenBmsBle),
+        cv.GenerateID(CONF_BASEN_BMS_BLE_ID): cv.use_id(BasenBms),
         cv.Optional(CONF_BALANCING): binary_sensor.binary_sensor_schema(
             icon="mdi:battery-heart-variant"
         ),
@@ -34,6 +41,8 @@ CONFIG_SCHEMA = cv.Schema(
     }
 )
 
+FINAL_VALIDATE_SCHEMA = final_validate_balancing_bitmap([CONF_BALANCING])
+
 
 async def to_code(config):
     hub = await cg.get_variable(config[CONF_BASEN_BMS_BLE_ID])
@@ -43,3 +52,5 @@ async def to_code(config):
             sens = cg.new_Pvariable(conf[CONF_ID])
             await binary_sensor.register_binary_sensor(sens, conf)
             cg.add(getattr(hub, f"set_{key}_binary_sensor")(sens))
+
+    request_frames(hub, config, BINARY_SENSORS)
@@ -0,0 +1,129 @@
+#include "cell_statistics.h"
+
+#include <cmath>
+
+namespace esphome {
+namespace basen_bms_ble {
+
+void CellStatistics::reset() {
+  for (auto &cell : this->cells_) {
+    cell.available = false;
+  }
+  for (uint8_t i = 0; i < WINDOW_BUCKETS; i++) {
+    this->bucket_samples_[i] = 0;
+  }
+  this->bucket_ = 0;
+  this->initialized_ = false;
+}
+
+void CellStatistics::start_bucket_(uint8_t bucket, uint32_t now) {
+  this->bucket_ = bucket;
+  this->bucket_start_[bucket] = now;
+  this->bucket_samples_[bucket] = 0;
+  for (auto &cell : this->cells_) {
+    cell.buckets[bucket].min = UINT16_MAX;
+    cell.buckets[bucket].max = 0;
+    cell.buckets[bucket].deviation_sum = 0;
+  }
+}
+
+void CellStatistics::update(const uint16_t *cell_voltages, uint8_t cells, uint32_t now) {
+  if (cells > MAX_CELLS) {
+    cells = MAX_CELLS;
+  }
+
+  if (!this->initialized_) {
+    this->start_bucket_(0, now);
+    this->initialized_ = true;
+  }
+
+  // Skip all buckets which elapsed since the last update (stale buckets are invalidated)
+  uint8_t elapsed = 0;
+  while (now - this->bucket_start_[this->bucket_] >= this->bucket_span_ && elapsed < WINDOW_BUCKETS) {
+    uint32_t next_start = this->bucket_start_[this->bucket_] + this->bucket_span_;
+    this->start_bucket_((this->bucket_ + 1) % WINDOW_BUCKETS, elapsed + 1 < WINDOW_BUCKETS ? next_start : now);
+    elapsed++;
+  }
+
+  uint32_t sum = 0;
+  uint8_t available = 0;
+  for (uint8_t i = 0; i < cells; i++) {
+    if (cell_voltages[i] > 0) {
+      sum += cell_voltages[i];
+      available++;
+    }
+  }
+  if (available == 0) {
+    return;
+  }
+  const float mean = (float) sum / available;
+
+  this->pack_average_ = 0.0f;
+  for (uint8_t i = 0; i < cells; i++) {
+    Cell &cell = this->cells_[i];
+    const uint16_t voltage = cell_voltages[i];
+    if (voltage == 0) {
+      cell.available = false;
+      continue;
+    }
+
+    cell.average = cell.available ? cell.average + this->smoothing_ * (voltage - cell.average) : voltage;
+    cell.available = true;
+    this->pack_average_ += cell.average;
+
+    Bucket &bucket = cell.buckets[this->bucket_];
+    if (voltage < bucket.min)
+      bucket.min = voltage;
+    if (voltage > bucket.max)
+      bucket.max = voltage;
+    bucket.deviation_sum += (int32_t) lroundf(voltage - mean);
+  }
+  this->pack_average_ /= available;
+  this->bucket_samples_[this->bucket_]++;
+}
+
+uint16_t CellStatistics::get_rolling_min(uint8_t cell) const {
+  uint16_t min = UINT16_MAX;
+  for (uint8_t i = 0; i < WINDOW_BUCKETS; i++) {
+    if (this->bucket_samples_[i] > 0 && this->cells_[cell].buckets[i].min < min) {
+      min = this->cells_[cell].buckets[i].min;
+    }
+  }
+  return min;
+}
+
+uint16_t CellStatistics::get_rolling_max(uint8_t cell) const {
+  uint16_t max = 0;
+  for (uint8_t i = 0; i < WINDOW_BUCKETS; i++) {
+    if (this->bucket_samples_[i] > 0 && this->cells_[cell].buckets[i].max > max) {
+      max = this->cells_[cell].buckets[i].max;
+    }
+  }
+  return max;
+}
+
+float CellStatistics::get_drift_rate(uint8_t cell) const {
+  // Compare the mean deviation of the oldest populated bucket with the current one
+  for (uint8_t age = WINDOW_BUCKETS - 1; age > 0; age--) {
+    const uint8_t oldest = (this->bucket_ + WINDOW_BUCKETS - age) % WINDOW_BUCKETS;
+    if (this->bucket_samples_[oldest] == 0 || this->bucket_samples_[this->bucket_] == 0) {
+      continue;
+    }
+
+    const Bucket &first = this->cells_[cell].buckets[oldest];
+    const Bucket &last = this->cells_[cell].buckets[this->bucket_];
+    const float first_deviation = (float) first.deviation_sum / this->bucket_samples_[oldest];
+    const float last_deviation = (float) last.deviation_sum / this->bucket_samples_[this->bucket_];
+    const float days = (float) (this->bucket_start_[this->bucket_] - this->bucket_start_[oldest]) / 86400000.0f;
+    if (days <= 0.0f) {
+      return NAN;
+    }
+
+    return (last_deviation - first_deviation) / days;
+  }
+
+  return NAN;
+}
+
+}  // namespace basen_bms_ble
+}  // namespace esphome
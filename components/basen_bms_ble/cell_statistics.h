@@ -0,0 +1,60 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+namespace esphome {
+namespace basen_bms_ble {
+
+// Fixed-memory per-cell statistics. The rolling window is split into buckets which keep the min/max and the
+// summed deviation from the pack mean of each cell. Every update is O(cells).
+class CellStatistics {
+ public:
+  static const uint8_t MAX_CELLS = 34;
+  static const uint8_t WINDOW_BUCKETS = 6;
+
+  // A bucket spans at least 1 ms: a span of zero would never rotate the buckets
+  void set_window(uint32_t window) { this->bucket_span_ = std::max<uint32_t>(window / WINDOW_BUCKETS, 1); }
+  void set_smoothing(float smoothing) { this->smoothing_ = smoothing; }
+
+  // Cell voltages in mV, cells reporting 0 mV are considered as not available
+  void update(const uint16_t *cell_voltages, uint8_t cells, uint32_t now);
+  void reset();
+
+  bool is_available(uint8_t cell) const { return this->cells_[cell].available; }
+  float get_average(uint8_t cell) const { return this->cells_[cell].average; }
+  // Deviation of the smoothed cell voltage from the smoothed pack mean in mV
+  float get_deviation(uint8_t cell) const { return this->cells_[cell].average - this->pack_average_; }
+  uint16_t get_rolling_min(uint8_t cell) const;
+  uint16_t get_rolling_max(uint8_t cell) const;
+  // Change of the deviation over the window in mV per day, NAN until two buckets are populated. The deviation is
+  // resolved to 1 mV and is extrapolated from a fraction of the window to a day, so short windows are noisy
+  float get_drift_rate(uint8_t cell) const;
+
+ protected:
+  struct Bucket {
+    uint16_t min;
+    uint16_t max;
+    int32_t deviation_sum;
+  };
+
+  struct Cell {
+    bool available{false};
+    float average{0.0f};
+    Bucket buckets[WINDOW_BUCKETS];
+  } cells_[MAX_CELLS];
+
+  uint32_t bucket_start_[WINDOW_BUCKETS]{};
+  uint16_t bucket_samples_[WINDOW_BUCKETS]{};
+  uint8_t bucket_{0};
+  bool initialized_{false};
+
+  uint32_t bucket_span_{3600000 / WINDOW_BUCKETS};
+  float smoothing_{0.2f};
+  float pack_average_{0.0f};
+
+  void start_bucket_(uint8_t bucket, uint32_t now);
+};
+
+}  // namespace basen_bms_ble
+}  // namespace esphome
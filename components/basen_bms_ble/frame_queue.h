@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace esphome {
+namespace basen_bms_ble {
+
+enum class FramePushResult { QUEUED, QUEUE_FULL, OVERSIZE };
+
+// Lock-free single-producer/single-consumer ring of fixed-size frames. The producer (BLE event path) never
+// blocks: if the consumer falls behind the frame is dropped and counted.
+template<size_t CAPACITY, size_t FRAME_SIZE> class FrameQueue {
+ public:
+  // Frames exceeding the slot size are rejected without being counted as dropped
+  FramePushResult push(const uint8_t *data, size_t length) {
+    if (length > FRAME_SIZE) {
+      return FramePushResult::OVERSIZE;
+    }
+
+    const uint32_t head = this->head_.load(std::memory_order_relaxed);
+    const uint32_t tail = this->tail_.load(std::memory_order_acquire);
+    if (head - tail >= CAPACITY) {
+      this->dropped_.fetch_add(1, std::memory_order_relaxed);
+      return FramePushResult::QUEUE_FULL;
+    }
+
+    Slot &slot = this->slots_[head % CAPACITY];
+    std::memcpy(slot.data, data, length);
+    slot.length = length;
+    this->head_.store(head + 1, std::memory_order_release);
+
+    const uint32_t depth = head + 1 - tail;
+    if (depth > this->high_water_.load(std::memory_order_relaxed)) {
+      this->high_water_.store(depth, std::memory_order_relaxed);
+    }
+    return FramePushResult::QUEUED;
+  }
+
+  // Reuses the capacity of the passed buffer to avoid allocations per frame
+  bool pop(std::vector<uint8_t> &frame) {
+    const uint32_t tail = this->tail_.load(std::memory_order_relaxed);
+    if (tail == this->head_.load(std::memory_order_acquire)) {
+      return false;
+    }
+
+    const Slot &slot = this->slots_[tail % CAPACITY];
+    frame.assign(slot.data, slot.data + slot.length);
+    this->tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  uint32_t size() const {
+    return this->head_.load(std::memory_order_acquire) - this->tail_.load(std::memory_order_acquire);
+  }
+  uint32_t dropped() const { return this->dropped_.load(std::memory_order_relaxed); }
+  // Returns the maximum depth since the last call
+  uint32_t reset_high_water() { return this->high_water_.exchange(this->size(), std::memory_order_relaxed); }
+
+ protected:
+  struct Slot {
+    uint8_t data[FRAME_SIZE];
+    size_t length;
+  } slots_[CAPACITY];
+
+  std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> tail_{0};
+  std::atomic<uint32_t> dropped_{0};
+  std::atomic<uint32_t> high_water_{0};
+};
+
+}  // namespace basen_bms_ble
+}  // namespace esphome
@@ -0,0 +1,211 @@
+#include "history_store.h"
+
+#include <cstring>
+
+namespace esphome {
+namespace basen_bms_ble {
+
+// Timestamp delta, number of channels and one zigzag varint per channel
+static const size_t MAX_RECORD_SIZE = 5 + 1 + 5 * HistoryStore::MAX_CHANNELS;
+
+static size_t put_varint(uint8_t *out, uint32_t value) {
+  size_t length = 0;
+  while (value >= 0x80) {
+    out[length++] = (uint8_t) (value | 0x80);
+    value >>= 7;
+  }
+  out[length++] = (uint8_t) value;
+  return length;
+}
+
+static uint32_t get_varint(const uint8_t *data, size_t end, size_t &pos) {
+  uint32_t value = 0;
+  for (uint8_t shift = 0; pos < end && shift < 35; shift += 7) {
+    const uint8_t byte = data[pos++];
+    value |= uint32_t(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      break;
+    }
+  }
+  return value;
+}
+
+static uint32_t zigzag_encode(int32_t value) { return ((uint32_t) value << 1) ^ (uint32_t) (value >> 31); }
+static int32_t zigzag_decode(uint32_t value) { return (int32_t) (value >> 1) ^ -(int32_t) (value & 1); }
+
+static void put_16bit(uint8_t *out, uint16_t value) {
+  out[0] = value >> 0;
+  out[1] = value >> 8;
+}
+
+bool HistoryStore::init(uint8_t *buffer, size_t size) {
+  if (buffer == nullptr || size / BLOCK_SIZE < 2) {
+    return false;
+  }
+
+  this->buffer_ = buffer;
+  this->blocks_ = size / BLOCK_SIZE > UINT16_MAX ? UINT16_MAX : size / BLOCK_SIZE;
+  this->first_block_ = 0;
+  this->last_block_ = 0;
+  this->records_ = 0;
+  this->empty_ = true;
+  this->start_block_(0, 0);
+  return true;
+}
+
+uint16_t HistoryStore::get_block_used_(uint16_t block) const {
+  const uint8_t *header = this->block_(block);
+  return uint16_t(header[0]) | (uint16_t(header[1]) << 8);
+}
+
+uint16_t HistoryStore::get_block_records_(uint16_t block) const {
+  const uint8_t *header = this->block_(block);
+  return uint16_t(header[2]) | (uint16_t(header[3]) << 8);
+}
+
+uint32_t HistoryStore::get_block_timestamp_(uint16_t block) const {
+  const uint8_t *header = this->block_(block);
+  return uint32_t(header[4]) | (uint32_t(header[5]) << 8) | (uint32_t(header[6]) << 16) | (uint32_t(header[7]) << 24);
+}
+
+void HistoryStore::start_block_(uint16_t block, uint32_t timestamp) {
+  uint8_t *header = this->block_(block);
+  put_16bit(header + 0, HEADER_SIZE);
+  put_16bit(header + 2, 0);
+  put_16bit(header + 4, timestamp & 0xFFFF);
+  put_16bit(header + 6, timestamp >> 16);
+}
+
+size_t HistoryStore::encode_(const Record &record, const Record *previous, uint32_t previous_timestamp,
+                             uint8_t *out) const {
+  size_t length = put_varint(out, record.timestamp - previous_timestamp);
+  out[length++] = record.channels;
+  for (uint8_t i = 0; i < record.channels; i++) {
+    const int32_t reference = (previous != nullptr && i < previous->channels) ? previous->values[i] : 0;
+    length += put_varint(out + length, zigzag_encode(record.values[i] - reference));
+  }
+  return length;
+}
+
+bool HistoryStore::append(const Record &input) {
+  if (this->buffer_ == nullptr || (!this->empty_ && input.timestamp < this->last_record_.timestamp)) {
+    return false;
+  }
+
+  Record record = input;
+  if (record.channels > MAX_CHANNELS) {
+    record.channels = MAX_CHANNELS;
+  }
+
+  uint8_t encoded[MAX_RECORD_SIZE];
+  size_t length;
+  uint16_t used = this->get_block_used_(this->last_block_);
+  if (used == HEADER_SIZE) {
+    // Empty block: the first record is stored absolute
+    this->start_block_(this->last_block_, record.timestamp);
+    length = this->encode_(record, nullptr, record.timestamp, encoded);
+  } else {
+    length = this->encode_(record, &this->last_record_, this->last_record_.timestamp, encoded);
+    if (used + length > BLOCK_SIZE) {
+      this->last_block_ = (this->last_block_ + 1) % this->blocks_;
+      if (this->last_block_ == this->first_block_) {
+        // Ring full: evict the oldest block
+        this->records_ -= this->get_block_records_(this->first_block_);
+        this->first_block_ = (this->first_block_ + 1) % this->blocks_;
+      }
+      this->start_block_(this->last_block_, record.timestamp);
+      used = HEADER_SIZE;
+      length = this->encode_(record, nullptr, record.timestamp, encoded);
+    }
+  }
+
+  uint8_t *block = this->block_(this->last_block_);
+  std::memcpy(block + used, encoded, length);
+  put_16bit(block + 0, used + length);
+  put_16bit(block + 2, this->get_block_records_(this->last_block_) + 1);
+
+  this->last_record_ = record;
+  this->records_++;
+  this->empty_ = false;
+  return true;
+}
+
+size_t HistoryStore::query(uint32_t start, uint32_t end, size_t limit,
+                           const std::function<void(const Record &)> &callback) const {
+  if (this->empty_ || limit == 0) {
+    return 0;
+  }
+
+  size_t count = 0;
+  Record record;
+  uint16_t block = this->first_block_;
+  while (true) {
+    const uint16_t next = (block + 1) % this->blocks_;
+    const bool last = block == this->last_block_;
+
+    // Skip blocks which end before the requested range (the next block starts earlier than the range)
+    if (!last && this->get_block_timestamp_(next) < start) {
+      block = next;
+      continue;
+    }
+    if (this->get_block_timestamp_(block) > end) {
+      break;
+    }
+
+    const uint8_t *data = this->block_(block);
+    const size_t used = this->get_block_used_(block);
+    size_t pos = HEADER_SIZE;
+    uint32_t timestamp = this->get_block_timestamp_(block);
+    bool first = true;
+    while (pos < used) {
+      timestamp += get_varint(data, used, pos);
+      const uint8_t channels = pos < used ? data[pos++] : 0;
+      for (uint8_t i = 0; i < channels && i < MAX_CHANNELS; i++) {
+        const int32_t reference = (!first && i < record.channels) ? record.values[i] : 0;
+        record.values[i] = reference + zigzag_decode(get_varint(data, used, pos));
+      }
+      record.timestamp = timestamp;
+      record.channels = channels;
+      first = false;
+
+      if (timestamp > end) {
+        return count;
+      }
+      if (timestamp >= start) {
+        callback(record);
+        if (++count >= limit) {
+          return count;
+        }
+      }
+    }
+
+    if (last) {
+      break;
+    }
+    block = next;
+  }
+
+  return count;
+}
+
+size_t HistoryStore::get_used() const {
+  if (this->buffer_ == nullptr) {
+    return 0;
+  }
+
+  size_t used = 0;
+  for (uint16_t block = this->first_block_;; block = (block + 1) % this->blocks_) {
+    used += this->get_block_used_(block);
+    if (block == this->last_block_) {
+      break;
+    }
+  }
+  return used;
+}
+
+uint32_t HistoryStore::get_oldest_timestamp() const {
+  return this->empty_ ? 0 : this->get_block_timestamp_(this->first_block_);
+}
+
+}  // namespace basen_bms_ble
+}  // namespace esphome
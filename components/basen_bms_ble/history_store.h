@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace esphome {
+namespace basen_bms_ble {
+
+// Compressed ring of snapshots in a caller provided buffer. The buffer is split into blocks: the first record of a
+// block is stored absolute, all following records as zigzag varint deltas of the previous record (cell voltages
+// change by a few mV between two samples, which fits into a single byte). If the ring is full, the oldest block is
+// evicted as a whole. Appending is O(channels) and never allocates.
+class HistoryStore {
+ public:
+  static const uint8_t MAX_CHANNELS = 43;
+  static const size_t BLOCK_SIZE = 1024;
+
+  struct Record {
+    uint32_t timestamp{0};
+    uint8_t channels{0};
+    int32_t values[MAX_CHANNELS]{};
+  };
+
+  // Returns false if the buffer doesn't hold at least two blocks
+  bool init(uint8_t *buffer, size_t size);
+  bool is_initialized() const { return this->buffer_ != nullptr; }
+
+  // Records older than the newest record are rejected to keep the blocks ordered by time
+  bool append(const Record &record);
+
+  // Decodes up to `limit` records with start <= timestamp <= end, oldest first. Returns the number of records passed
+  // to the callback
+  size_t query(uint32_t start, uint32_t end, size_t limit, const std::function<void(const Record &)> &callback) const;
+
+  size_t get_capacity() const { return (size_t) this->blocks_ * BLOCK_SIZE; }
+  size_t get_used() const;
+  uint32_t get_records() const { return this->records_; }
+  uint32_t get_oldest_timestamp() const;
+
+ protected:
+  // Block header: used bytes (incl. header), number of records and the timestamp of the first record
+  static const size_t HEADER_SIZE = 8;
+
+  uint8_t *buffer_{nullptr};
+  uint16_t blocks_{0};
+  uint16_t first_block_{0};
+  uint16_t last_block_{0};
+  uint32_t records_{0};
+  bool empty_{true};
+  Record last_record_;
+
+  uint8_t *block_(uint16_t block) const { return this->buffer_ + (size_t) block * BLOCK_SIZE; }
+  uint16_t get_block_used_(uint16_t block) const;
+  uint16_t get_block_records_(uint16_t block) const;
+  uint32_t get_block_timestamp_(uint16_t block) const;
+  void start_block_(uint16_t block, uint32_t timestamp);
+  size_t encode_(const Record &record, const Record *previous, uint32_t previous_timestamp, uint8_t *out) const;
+};
+
+}  // namespace basen_bms_ble
+}  // namespace esphome
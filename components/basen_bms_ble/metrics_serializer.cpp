@@ -0,0 +1,182 @@
+#include "metrics_serializer.h"
+
+#include <cstdarg>
+#include <cstdio>
+
+namespace esphome {
+namespace basen_bms_ble {
+
+struct Gauge {
+  const char *name;  // Prometheus metric name (without the basen_bms_ prefix)
+  const char *key;   // JSON key
+  const char *help;
+  uint8_t decimals;
+  float PackState::*value;
+};
+
+struct Counter {
+  const char *name;
+  const char *key;
+  const char *help;
+  uint32_t PackState::*value;
+};
+
+static const Gauge GAUGES[] = {
+    {"total_voltage_volts", "total_voltage", "Total voltage", 3, &PackState::total_voltage},
+    {"current_amperes", "current", "Current (positive while charging)", 3, &PackState::current},
+    {"power_watts", "power", "Power (positive while charging)", 1, &PackState::power},
+    {"capacity_remaining_ampere_hours", "capacity_remaining", "Capacity remaining", 3,
+     &PackState::capacity_remaining},
+    {"state_of_charge_percent", "state_of_charge", "State of charge", 0, &PackState::state_of_charge},
+    {"charging_states", "charging_states", "Charging states bitmask", 0, &PackState::charging_states},
+    {"discharging_states", "discharging_states", "Discharging states bitmask", 0, &PackState::discharging_states},
+    {"charging_warnings", "charging_warnings", "Charging warnings bitmask", 0, &PackState::charging_warnings},
+    {"discharging_warnings", "discharging_warnings", "Discharging warnings bitmask", 0,
+     &PackState::discharging_warnings},
+    {"nominal_capacity_ampere_hours", "nominal_capacity", "Nominal capacity", 3, &PackState::nominal_capacity},
+    {"nominal_voltage_volts", "nominal_voltage", "Nominal voltage", 3, &PackState::nominal_voltage},
+    {"real_capacity_ampere_hours", "real_capacity", "Real capacity", 3, &PackState::real_capacity},
+    {"serial_number", "serial_number", "Serial number", 0, &PackState::serial_number},
+    {"charging_cycles", "charging_cycles", "Charging cycles", 0, &PackState::charging_cycles},
+    {"update_interval_seconds", "update_interval", "Effective update interval", 1, &PackState::update_interval},
+};
+
+static const Counter COUNTERS[] = {
+    {"frames_received_total", "frames_received", "Valid frames received", &PackState::frames_received},
+    {"length_errors_total", "length_errors", "Frames with an invalid length", &PackState::length_errors},
+    {"crc_errors_total", "crc_errors", "Frames with an invalid CRC", &PackState::crc_errors},
+    {"unknown_address_frames_total", "unknown_address_frames", "Frames of an unknown address",
+     &PackState::unknown_address_frames},
+    {"dropped_frames_total", "dropped_frames", "Frames dropped by a full frame queue", &PackState::dropped_frames},
+};
+
+void MetricsSerializer::reset() {
+  this->length_ = 0;
+  this->truncated_ = this->size_ == 0;
+  if (this->size_ > 0) {
+    this->buffer_[0] = '\0';
+  }
+}
+
+void MetricsSerializer::append_(const char *format, ...) {
+  if (this->truncated_) {
+    return;
+  }
+
+  const size_t available = this->size_ - this->length_;
+  va_list args;
+  va_start(args, format);
+  const int written = vsnprintf(this->buffer_ + this->length_, available, format, args);
+  va_end(args);
+
+  if (written < 0 || (size_t) written >= available) {
+    // Cut at the last complete append
+    this->buffer_[this->length_] = '\0';
+    this->truncated_ = true;
+    return;
+  }
+  this->length_ += written;
+}
+
+void MetricsSerializer::append_family_(const char *name, const char *type, const char *help) {
+  this->append_("# HELP basen_bms_%s %s\n# TYPE basen_bms_%s %s\n", name, help, name, type);
+}
+
+void MetricsSerializer::write_prometheus(const PackState *const *states, size_t count) {
+  // All samples of a metric family are grouped below its HELP and TYPE lines
+  for (const auto &gauge : GAUGES) {
+    this->append_family_(gauge.name, "gauge", gauge.help);
+    for (size_t i = 0; i < count; i++) {
+      const float value = states[i]->*gauge.value;
+      if (!std::isnan(value)) {
+        this->append_("basen_bms_%s{address=\"0x%02X\"} %.*f\n", gauge.name, states[i]->address, gauge.decimals,
+                      value);
+      }
+    }
+  }
+
+  this->append_family_("temperature_celsius", "gauge", "Temperature");
+  for (size_t i = 0; i < count; i++) {
+    for (uint8_t sensor = 0; sensor < PackState::TEMPERATURES; sensor++) {
+      if (!std::isnan(states[i]->temperatures[sensor])) {
+        this->append_("basen_bms_temperature_celsius{address=\"0x%02X\",sensor=\"%u\"} %.0f\n", states[i]->address,
+                      sensor + 1, states[i]->temperatures[sensor]);
+      }
+    }
+  }
+
+  this->append_family_("cell_voltage_volts", "gauge", "Cell voltage");
+  for (size_t i = 0; i < count; i++) {
+    for (uint8_t cell = 0; cell < states[i]->cell_count && cell < PackState::MAX_CELLS; cell++) {
+      if (states[i]->cell_voltages[cell] > 0) {
+        this->append_("basen_bms_cell_voltage_volts{address=\"0x%02X\",cell=\"%u\"} %u.%03u\n", states[i]->address,
+                      cell + 1, states[i]->cell_voltages[cell] / 1000, states[i]->cell_voltages[cell] % 1000);
+      }
+    }
+  }
+
+  this->append_family_("cell_balancing", "gauge", "Cell balancing active");
+  for (size_t i = 0; i < count; i++) {
+    if (!states[i]->balancing_cells_valid) {
+      continue;
+    }
+    for (uint8_t cell = 0; cell < states[i]->cell_count && cell < PackState::MAX_CELLS; cell++) {
+      this->append_("basen_bms_cell_balancing{address=\"0x%02X\",cell=\"%u\"} %u\n", states[i]->address, cell + 1,
+                    (unsigned) ((states[i]->balancing_cells >> cell) & 1));
+    }
+  }
+
+  for (const auto &counter : COUNTERS) {
+    this->append_family_(counter.name, "counter", counter.help);
+    for (size_t i = 0; i < count; i++) {
+      this->append_("basen_bms_%s{address=\"0x%02X\"} %u\n", counter.name, states[i]->address,
+                    (unsigned) (states[i]->*counter.value));
+    }
+  }
+}
+
+void MetricsSerializer::write_json(const PackState *const *states, size_t count) {
+  this->append_("{\"packs\":[");
+  for (size_t i = 0; i < count; i++) {
+    const PackState &state = *states[i];
+    this->append_("%s{\"address\":%u", i == 0 ? "" : ",", state.address);
+
+    for (const auto &gauge : GAUGES) {
+      const float value = state.*gauge.value;
+      if (std::isnan(value)) {
+        this->append_(",\"%s\":null", gauge.key);
+      } else {
+        this->append_(",\"%s\":%.*f", gauge.key, gauge.decimals, value);
+      }
+    }
+
+    this->append_(",\"temperatures\":[");
+    for (uint8_t sensor = 0; sensor < PackState::TEMPERATURES; sensor++) {
+      if (std::isnan(state.temperatures[sensor])) {
+        this->append_("%snull", sensor == 0 ? "" : ",");
+      } else {
+        this->append_("%s%.0f", sensor == 0 ? "" : ",", state.temperatures[sensor]);
+      }
+    }
+
+    // Cell voltages in mV, 0 if not available
+    this->append_("],\"cell_voltages\":[");
+    for (uint8_t cell = 0; cell < state.cell_count && cell < PackState::MAX_CELLS; cell++) {
+      this->append_("%s%u", cell == 0 ? "" : ",", state.cell_voltages[cell]);
+    }
+    if (state.balancing_cells_valid) {
+      this->append_("],\"balancing_cells\":%llu", (unsigned long long) state.balancing_cells);
+    } else {
+      this->append_("],\"balancing_cells\":null");
+    }
+
+    for (const auto &counter : COUNTERS) {
+      this->append_(",\"%s\":%u", counter.key, (unsigned) (state.*counter.value));
+    }
+    this->append_("}");
+  }
+  this->append_("]}");
+}
+
+}  // namespace basen_bms_ble
+}  // namespace esphome
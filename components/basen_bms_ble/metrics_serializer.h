@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "pack_state.h"
+
+namespace esphome {
+namespace basen_bms_ble {
+
+// Serializes the state of one or more packs into a caller provided buffer (Prometheus text exposition format or
+// JSON). Nothing is allocated; if the buffer is too small the output is cut and is_truncated() is set.
+class MetricsSerializer {
+ public:
+  // Worst case of the Prometheus output (34 cells, every value at its widest): 2394 bytes of HELP/TYPE lines and
+  // 5277 bytes per pack. The JSON output is smaller.
+  static const size_t BUFFER_SIZE_BASE = 2560;
+  static const size_t BUFFER_SIZE_PER_PACK = 5632;
+
+  static size_t get_buffer_size(size_t packs) { return BUFFER_SIZE_BASE + BUFFER_SIZE_PER_PACK * packs; }
+
+  MetricsSerializer(char *buffer, size_t size) : buffer_(buffer), size_(size) { this->reset(); }
+
+  void reset();
+  void write_prometheus(const PackState *const *states, size_t count);
+  void write_json(const PackState *const *states, size_t count);
+
+  const char *get_buffer() const { return this->buffer_; }
+  size_t get_length() const { return this->length_; }
+  bool is_truncated() const { return this->truncated_; }
+
+ protected:
+  char *buffer_;
+  size_t size_;
+  size_t length_{0};
+  bool truncated_{false};
+
+  void append_(const char *format, ...) __attribute__((format(printf, 2, 3)));
+  void append_family_(const char *name, const char *type, const char *help);
+};
+
+}  // namespace basen_bms_ble
+}  // namespace esphome
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+namespace esphome {
+namespace basen_bms_ble {
+
+// Latest decoded values of a pack independent of the configured entities. Values which weren't received yet are NAN.
+struct PackState {
+  static const uint8_t MAX_CELLS = 34;
+  static const uint8_t TEMPERATURES = 4;
+
+  uint8_t address{0};
+
+  // Status frame
+  float total_voltage{NAN};
+  float current{NAN};
+  float power{NAN};
+  float capacity_remaining{NAN};
+  float state_of_charge{NAN};
+  float charging_states{NAN};
+  float discharging_states{NAN};
+  float charging_warnings{NAN};
+  float discharging_warnings{NAN};
+  float temperatures[TEMPERATURES]{NAN, NAN, NAN, NAN};
+
+  // General info frame
+  float nominal_capacity{NAN};
+  float nominal_voltage{NAN};
+  float real_capacity{NAN};
+  float serial_number{NAN};
+  float charging_cycles{NAN};
+
+  // Cell voltage and balancing frames (mV, 0 = not available)
+  uint8_t cell_count{0};
+  uint16_t cell_voltages[MAX_CELLS]{};
+  uint64_t balancing_cells{0};
+  // The balancing bitmap is experimental (unconfirmed offset) and decoded on request only
+  bool balancing_cells_valid{false};
+
+  // Link and decoder metrics
+  float update_interval{NAN};
+  uint32_t frames_received{0};
+  uint32_t length_errors{0};
+  uint32_t crc_errors{0};
+  uint32_t unknown_address_frames{0};
+  uint32_t dropped_frames{0};
+};
+
+}  // namespace basen_bms_ble
+}  // namespace esphome
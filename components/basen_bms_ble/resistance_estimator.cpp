@@ -0,0 +1,83 @@
+#include "resistance_estimator.h"
+
+#include <algorithm>
+
+namespace esphome {
+namespace basen_bms_ble {
+
+// Samples further apart are dominated by polarization and state of charge changes
+static const uint32_t MAX_SAMPLE_GAP_MS = 60000;
+static const float MAX_PACK_RESISTANCE = 1.0f;
+static const float MAX_CELL_RESISTANCE = 0.1f;
+static const float SMOOTHING = 0.2f;
+
+void ResistanceEstimator::Estimate::add(float resistance, float max_resistance) {
+  // Implausible values caused by a sign change of the voltage response are rejected
+  if (!(resistance > 0.0f && resistance < max_resistance)) {
+    return;
+  }
+
+  this->candidates[this->next_candidate] = resistance;
+  this->next_candidate = (this->next_candidate + 1) % 3;
+
+  float a = this->candidates[0], b = this->candidates[1], c = this->candidates[2];
+  if (std::isnan(b) || std::isnan(c)) {
+    // Not enough candidates for the median filter yet
+    this->estimate = std::isnan(this->estimate) ? resistance : this->estimate;
+    return;
+  }
+
+  float median = std::max(std::min(a, b), std::min(std::max(a, b), c));
+  this->estimate = std::isnan(this->estimate) ? median : this->estimate + SMOOTHING * (median - this->estimate);
+}
+
+bool ResistanceEstimator::is_step_(float previous_current, uint32_t previous_timestamp, uint32_t now) const {
+  if (std::isnan(previous_current) || std::isnan(this->current_)) {
+    return false;
+  }
+
+  return now - previous_timestamp <= MAX_SAMPLE_GAP_MS &&
+         std::abs(this->current_ - previous_current) >= this->min_current_step_;
+}
+
+void ResistanceEstimator::update_pack(float voltage, float current, uint32_t now) {
+  this->current_ = current;
+
+  if (this->is_step_(this->last_pack_sample_.current, this->last_pack_sample_.timestamp, now)) {
+    float resistance = (voltage - this->last_pack_sample_.voltage) / (current - this->last_pack_sample_.current);
+    this->pack_.add(resistance, MAX_PACK_RESISTANCE);
+  }
+
+  this->last_pack_sample_.voltage = voltage;
+  this->last_pack_sample_.current = current;
+  this->last_pack_sample_.timestamp = now;
+}
+
+void ResistanceEstimator::update_cells(const uint16_t *cell_voltages, uint8_t cells, uint32_t now) {
+  if (cells > MAX_CELLS) {
+    cells = MAX_CELLS;
+  }
+
+  bool step = this->is_step_(this->last_cell_current_, this->last_cell_timestamp_, now);
+  float current_step = this->current_ - this->last_cell_current_;
+
+  for (uint8_t i = 0; i < cells; i++) {
+    Cell &cell = this->cells_[i];
+    if (cell_voltages[i] == 0) {
+      cell.voltage = NAN;
+      continue;
+    }
+
+    float voltage = cell_voltages[i] * 0.001f;
+    if (step && !std::isnan(cell.voltage)) {
+      cell.estimate.add((voltage - cell.voltage) / current_step, MAX_CELL_RESISTANCE);
+    }
+    cell.voltage = voltage;
+  }
+
+  this->last_cell_current_ = this->current_;
+  this->last_cell_timestamp_ = now;
+}
+
+}  // namespace basen_bms_ble
+}  // namespace esphome
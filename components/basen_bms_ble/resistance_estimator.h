@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+namespace esphome {
+namespace basen_bms_ble {
+
+// Online DC internal resistance estimation (dV/dI) from load steps between two consecutive samples.
+// Candidates are median-of-three filtered and exponentially smoothed afterwards. Memory is bounded by the
+// number of cells.
+class ResistanceEstimator {
+ public:
+  static const uint8_t MAX_CELLS = 34;
+
+  void set_min_current_step(float min_current_step) { this->min_current_step_ = min_current_step; }
+
+  // Total voltage and current of a status frame
+  void update_pack(float voltage, float current, uint32_t now);
+  // Cell voltages in mV, measured at the current of the last status frame
+  void update_cells(const uint16_t *cell_voltages, uint8_t cells, uint32_t now);
+
+  // Resistances in Ohm, NAN until the first load step was detected
+  float get_pack_resistance() const { return this->pack_.estimate; }
+  float get_cell_resistance(uint8_t cell) const { return this->cells_[cell].estimate.estimate; }
+
+ protected:
+  struct Estimate {
+    float candidates[3]{NAN, NAN, NAN};
+    uint8_t next_candidate{0};
+    float estimate{NAN};
+
+    void add(float resistance, float max_resistance);
+  };
+
+  struct Sample {
+    float voltage{NAN};
+    float current{NAN};
+    uint32_t timestamp{0};
+  };
+
+  struct Cell {
+    float voltage{NAN};
+    Estimate estimate;
+  } cells_[MAX_CELLS];
+
+  Estimate pack_;
+  Sample last_pack_sample_;
+  float last_cell_current_{NAN};
+  uint32_t last_cell_timestamp_{0};
+  float current_{NAN};
+
+  float min_current_step_{3.0f};
+
+  bool is_step_(float previous_current, uint32_t previous_timestamp, uint32_t now) const;
+};
+
+}  // namespace basen_bms_ble
+}  // namespace esphome
@@ -6,21 +6,36 @@ from esphome.const import (
     CONF_POWER,
     DEVICE_CLASS_BATTERY,
     DEVICE_CLASS_CURRENT,
+    DEVICE_CLASS_DURATION,
     DEVICE_CLASS_EMPTY,
     DEVICE_CLASS_POWER,
     DEVICE_CLASS_TEMPERATURE,
     DEVICE_CLASS_VOLTAGE,
+    ENTITY_CATEGORY_DIAGNOSTIC,
     ICON_EMPTY,
     STATE_CLASS_MEASUREMENT,
+    STATE_CLASS_TOTAL_INCREASING,
     UNIT_AMPERE,
     UNIT_CELSIUS,
     UNIT_EMPTY,
     UNIT_PERCENT,
+    UNIT_SECOND,
     UNIT_VOLT,
     UNIT_WATT,
 )
 
-from . import CONF_BASEN_BMS_BLE_ID, BasenBmsBle
+from . import (
+    CONF_BASEN_BMS_BLE_ID,
+    FRAME_TYPE_BALANCING,
+    FRAME_TYPE_CELL_VOLTAGES_1_12,
+    FRAME_TYPE_CELL_VOLTAGES_13_24,
+    FRAME_TYPE_GENERAL_INFO,
+    FRAME_TYPE_STATUS,
+    FRAME_TYPES_CELL_VOLTAGES,
+    BasenBms,
+    final_validate_balancing_bitmap,
+    request_frames,
+)
 
 DEPENDENCIES = ["basen_bms_ble"]
 
@@ -48,6 +63,22 @@ CONF_MIN_VOLTAGE_CELL = "min_voltage_cell"
 CONF_MAX_VOLTAGE_CELL = "max_voltage_cell"
 CONF_DELTA_CELL_VOLTAGE = "delta_cell_voltage"
 CONF_AVERAGE_CELL_VOLTAGE = "average_cell_voltage"
+CONF_MAX_CELL_DEVIATION = "max_cell_deviation"
+CONF_MAX_DEVIATION_CELL = "max_deviation_cell"
+CONF_MAX_CELL_DRIFT_RATE = "max_cell_drift_rate"
+CONF_MAX_DRIFT_CELL = "max_drift_cell"
+CONF_ROLLING_MIN_CELL_VOLTAGE = "rolling_min_cell_voltage"
+CONF_ROLLING_MAX_CELL_VOLTAGE = "rolling_max_cell_voltage"
+CONF_INTERNAL_RESISTANCE = "internal_resistance"
+CONF_AVERAGE_CELL_INTERNAL_RESISTANCE = "average_cell_internal_resistance"
+CONF_MAX_CELL_INTERNAL_RESISTANCE = "max_cell_internal_resistance"
+CONF_MAX_INTERNAL_RESISTANCE_CELL = "max_internal_resistance_cell"
+CONF_BALANCING_CELL_COUNT = "balancing_cell_count"
+CONF_EFFECTIVE_UPDATE_INTERVAL = "effective_update_interval"
+CONF_FRAME_QUEUE_DEPTH = "frame_queue_depth"
+CONF_DROPPED_FRAMES = "dropped_frames"
+CONF_WAKE_TO_DATA_TIME = "wake_to_data_time"
+CONF_DUTY_CYCLE = "duty_cycle"
 
 CONF_CELL_VOLTAGE_1 = "cell_voltage_1"
 CONF_CELL_VOLTAGE_2 = "cell_voltage_2"
@@ -103,8 +134,26 @@ ICON_CHARGING_WARNINGS_BITMASK = "mdi:alert-circle-outline"
 ICON_DISCHARGING_WARNINGS_BITMASK = "mdi:alert-circle-outline"
 ICON_REAL_CAPACITY = "mdi:battery-high"
 ICON_SERIAL_NUMBER = "mdi:numeric"
+ICON_MAX_CELL_DEVIATION = "mdi:battery-alert-variant-outline"
+ICON_MAX_DEVIATION_CELL = "mdi:battery-alert-variant-outline"
+ICON_MAX_CELL_DRIFT_RATE = "mdi:chart-line-variant"
+ICON_MAX_DRIFT_CELL = "mdi:chart-line-variant"
+ICON_ROLLING_MIN_CELL_VOLTAGE = "mdi:battery-minus-outline"
+ICON_ROLLING_MAX_CELL_VOLTAGE = "mdi:battery-plus-outline"
+ICON_INTERNAL_RESISTANCE = "mdi:omega"
+ICON_AVERAGE_CELL_INTERNAL_RESISTANCE = "mdi:omega"
+ICON_MAX_CELL_INTERNAL_RESISTANCE = "mdi:omega"
+ICON_MAX_INTERNAL_RESISTANCE_CELL = "mdi:omega"
+ICON_BALANCING_CELL_COUNT = "mdi:battery-heart-variant"
+ICON_EFFECTIVE_UPDATE_INTERVAL = "mdi:timer-sync-outline"
+ICON_FRAME_QUEUE_DEPTH = "mdi:tray-full"
+ICON_DROPPED_FRAMES = "mdi:package-variant-remove"
+ICON_WAKE_TO_DATA_TIME = "mdi:timer-sand"
+ICON_DUTY_CYCLE = "mdi:sleep"
 
 UNIT_AMPERE_HOURS = "Ah"
+UNIT_MILLIVOLT_PER_DAY = "mV/d"
+UNIT_MILLIOHM = "mΩ"
 
 CELLS = [
     CONF_CELL_VOLTAGE_1,
@@ -150,35 +199,60 @@ TEMPERATURES = [
     CONF_TEMPERATURE_4,
 ]
 
-SENSORS = [
-    CONF_TOTAL_VOLTAGE,
-    CONF_CURRENT,
-    CONF_POWER,
-    CONF_CHARGING_POWER,
-    CONF_DISCHARGING_POWER,
-    CONF_CAPACITY_REMAINING,
-    CONF_CHARGING_STATES_BITMASK,
-    CONF_DISCHARGING_STATES_BITMASK,
-    CONF_CHARGING_WARNINGS_BITMASK,
-    CONF_DISCHARGING_WARNINGS_BITMASK,
-    CONF_STATE_OF_CHARGE,
-    CONF_NOMINAL_CAPACITY,
-    CONF_NOMINAL_VOLTAGE,
-    CONF_REAL_CAPACITY,
-    CONF_SERIAL_NUMBER,
-    CONF_CHARGING_CYCLES,
-    CONF_MIN_CELL_VOLTAGE,
-    CONF_MAX_CELL_VOLTAGE,
-    CONF_MIN_VOLTAGE_CELL,
-    CONF_MAX_VOLTAGE_CELL,
-    CONF_DELTA_CELL_VOLTAGE,
-    CONF_AVERAGE_CELL_VOLTAGE,
+# Aggregated cell sensors need the chunks of cells 1-24 at least
+CELL_VOLTAGE_AGGREGATE_FRAMES = [
+    FRAME_TYPE_CELL_VOLTAGES_1_12,
+    FRAME_TYPE_CELL_VOLTAGES_13_24,
 ]
 
+# The cell voltages are related to the current of the previous status frame
+CELL_INTERNAL_RESISTANCE_FRAMES = [FRAME_TYPE_STATUS] + CELL_VOLTAGE_AGGREGATE_FRAMES
+
+SENSORS = {
+    CONF_TOTAL_VOLTAGE: [FRAME_TYPE_STATUS],
+    CONF_CURRENT: [FRAME_TYPE_STATUS],
+    CONF_POWER: [FRAME_TYPE_STATUS],
+    CONF_CHARGING_POWER: [FRAME_TYPE_STATUS],
+    CONF_DISCHARGING_POWER: [FRAME_TYPE_STATUS],
+    CONF_CAPACITY_REMAINING: [FRAME_TYPE_STATUS],
+    CONF_CHARGING_STATES_BITMASK: [FRAME_TYPE_STATUS],
+    CONF_DISCHARGING_STATES_BITMASK: [FRAME_TYPE_STATUS],
+    CONF_CHARGING_WARNINGS_BITMASK: [FRAME_TYPE_STATUS],
+    CONF_DISCHARGING_WARNINGS_BITMASK: [FRAME_TYPE_STATUS],
+    CONF_STATE_OF_CHARGE: [FRAME_TYPE_STATUS],
+    CONF_NOMINAL_CAPACITY: [FRAME_TYPE_GENERAL_INFO],
+    CONF_NOMINAL_VOLTAGE: [FRAME_TYPE_GENERAL_INFO],
+    CONF_REAL_CAPACITY: [FRAME_TYPE_GENERAL_INFO],
+    CONF_SERIAL_NUMBER: [FRAME_TYPE_GENERAL_INFO],
+    CONF_CHARGING_CYCLES: [FRAME_TYPE_GENERAL_INFO],
+    CONF_MIN_CELL_VOLTAGE: CELL_VOLTAGE_AGGREGATE_FRAMES,
+    CONF_MAX_CELL_VOLTAGE: CELL_VOLTAGE_AGGREGATE_FRAMES,
+    CONF_MIN_VOLTAGE_CELL: CELL_VOLTAGE_AGGREGATE_FRAMES,
+    CONF_MAX_VOLTAGE_CELL: CELL_VOLTAGE_AGGREGATE_FRAMES,
+    CONF_DELTA_CELL_VOLTAGE: CELL_VOLTAGE_AGGREGATE_FRAMES,
+    CONF_AVERAGE_CELL_VOLTAGE: CELL_VOLTAGE_AGGREGATE_FRAMES,
+    CONF_MAX_CELL_DEVIATION: CELL_VOLTAGE_AGGREGATE_FRAMES,
+    CONF_MAX_DEVIATION_CELL: CELL_VOLTAGE_AGGREGATE_FRAMES,
+    CONF_MAX_CELL_DRIFT_RATE: CELL_VOLTAGE_AGGREGATE_FRAMES,
+    CONF_MAX_DRIFT_CELL: CELL_VOLTAGE_AGGREGATE_FRAMES,
+    CONF_ROLLING_MIN_CELL_VOLTAGE: CELL_VOLTAGE_AGGREGATE_FRAMES,
+    CONF_ROLLING_MAX_CELL_VOLTAGE: CELL_VOLTAGE_AGGREGATE_FRAMES,
+    CONF_INTERNAL_RESISTANCE: [FRAME_TYPE_STATUS],
+    CONF_AVERAGE_CELL_INTERNAL_RESISTANCE: CELL_INTERNAL_RESISTANCE_FRAMES,
+    CONF_MAX_CELL_INTERNAL_RESISTANCE: CELL_INTERNAL_RESISTANCE_FRAMES,
+    CONF_MAX_INTERNAL_RESISTANCE_CELL: CELL_INTERNAL_RESISTANCE_FRAMES,
+    CONF_BALANCING_CELL_COUNT: [FRAME_TYPE_BALANCING],
+    CONF_EFFECTIVE_UPDATE_INTERVAL: [],
+    CONF_FRAME_QUEUE_DEPTH: [],
+    CONF_DROPPED_FRAMES: [],
+    CONF_WAKE_TO_DATA_TIME: [],
+    CONF_DUTY_CYCLE: [],
+}
+
 # pylint: disable=too-many-function-args
 CONFIG_SCHEMA = cv.Schema(
     {
-        cv.GenerateID(CONF_BASEN_BMS_BLE_ID): cv.use_id(BasenBmsBle),
+        cv.GenerateID(CONF_BASEN_BMS_BLE_ID): cv.use_id(BasenBms),
         cv.Optional(CONF_TOTAL_VOLTAGE): sensor.sensor_schema(
             unit_of_measurement=UNIT_VOLT,
             icon=ICON_EMPTY,
@@ -331,6 +405,125 @@ CONFIG_SCHEMA = cv.Schema(
             device_class=DEVICE_CLASS_VOLTAGE,
             state_class=STATE_CLASS_MEASUREMENT,
         ),
+        cv.Optional(CONF_MAX_CELL_DEVIATION): sensor.sensor_schema(
+            unit_of_measurement=UNIT_VOLT,
+            icon=ICON_MAX_CELL_DEVIATION,
+            accuracy_decimals=3,
+            device_class=DEVICE_CLASS_VOLTAGE,
+            state_class=STATE_CLASS_MEASUREMENT,
+        ),
+        cv.Optional(CONF_MAX_DEVIATION_CELL): sensor.sensor_schema(
+            unit_of_measurement=UNIT_EMPTY,
+            icon=ICON_MAX_DEVIATION_CELL,
+            accuracy_decimals=0,
+            device_class=DEVICE_CLASS_EMPTY,
+            state_class=STATE_CLASS_MEASUREMENT,
+        ),
+        # A 1 mV change of the deviation within a window of 1h reads as 24 mV/day. Use a
+        # cell_statistics_window of several hours or days for a meaningful drift rate.
+        cv.Optional(CONF_MAX_CELL_DRIFT_RATE): sensor.sensor_schema(
+            unit_of_measurement=UNIT_MILLIVOLT_PER_DAY,
+            icon=ICON_MAX_CELL_DRIFT_RATE,
+            accuracy_decimals=1,
+            device_class=DEVICE_CLASS_EMPTY,
+            state_class=STATE_CLASS_MEASUREMENT,
+        ),
+        cv.Optional(CONF_MAX_DRIFT_CELL): sensor.sensor_schema(
+            unit_of_measurement=UNIT_EMPTY,
+            icon=ICON_MAX_DRIFT_CELL,
+            accuracy_decimals=0,
+            device_class=DEVICE_CLASS_EMPTY,
+            state_class=STATE_CLASS_MEASUREMENT,
+        ),
+        cv.Optional(CONF_ROLLING_MIN_CELL_VOLTAGE): sensor.sensor_schema(
+            unit_of_measurement=UNIT_VOLT,
+            icon=ICON_ROLLING_MIN_CELL_VOLTAGE,
+            accuracy_decimals=3,
+            device_class=DEVICE_CLASS_VOLTAGE,
+            state_class=STATE_CLASS_MEASUREMENT,
+        ),
+        cv.Optional(CONF_ROLLING_MAX_CELL_VOLTAGE): sensor.sensor_schema(
+            unit_of_measurement=UNIT_VOLT,
+            icon=ICON_ROLLING_MAX_CELL_VOLTAGE,
+            accuracy_decimals=3,
+            device_class=DEVICE_CLASS_VOLTAGE,
+            state_class=STATE_CLASS_MEASUREMENT,
+        ),
+        cv.Optional(CONF_INTERNAL_RESISTANCE): sensor.sensor_schema(
+            unit_of_measurement=UNIT_MILLIOHM,
+            icon=ICON_INTERNAL_RESISTANCE,
+            accuracy_decimals=1,
+            device_class=DEVICE_CLASS_EMPTY,
+            state_class=STATE_CLASS_MEASUREMENT,
+        ),
+        cv.Optional(CONF_AVERAGE_CELL_INTERNAL_RESISTANCE): sensor.sensor_schema(
+            unit_of_measurement=UNIT_MILLIOHM,
+            icon=ICON_AVERAGE_CELL_INTERNAL_RESISTANCE,
+            accuracy_decimals=2,
+            device_class=DEVICE_CLASS_EMPTY,
+            state_class=STATE_CLASS_MEASUREMENT,
+        ),
+        cv.Optional(CONF_MAX_CELL_INTERNAL_RESISTANCE): sensor.sensor_schema(
+            unit_of_measurement=UNIT_MILLIOHM,
+            icon=ICON_MAX_CELL_INTERNAL_RESISTANCE,
+            accuracy_decimals=2,
+            device_class=DEVICE_CLASS_EMPTY,
+            state_class=STATE_CLASS_MEASUREMENT,
+        ),
+        cv.Optional(CONF_MAX_INTERNAL_RESISTANCE_CELL): sensor.sensor_schema(
+            unit_of_measurement=UNIT_EMPTY,
+            icon=ICON_MAX_INTERNAL_RESISTANCE_CELL,
+            accuracy_decimals=0,
+            device_class=DEVICE_CLASS_EMPTY,
+            state_class=STATE_CLASS_MEASUREMENT,
+        ),
+        cv.Optional(CONF_BALANCING_CELL_COUNT): sensor.sensor_schema(
+            unit_of_measurement=UNIT_EMPTY,
+            icon=ICON_BALANCING_CELL_COUNT,
+            accuracy_decimals=0,
+            device_class=DEVICE_CLASS_EMPTY,
+            state_class=STATE_CLASS_MEASUREMENT,
+        ),
+        cv.Optional(CONF_EFFECTIVE_UPDATE_INTERVAL): sensor.sensor_schema(
+            unit_of_measurement=UNIT_SECOND,
+            icon=ICON_EFFECTIVE_UPDATE_INTERVAL,
+            accuracy_decimals=0,
+            device_class=DEVICE_CLASS_DURATION,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_FRAME_QUEUE_DEPTH): sensor.sensor_schema(
+            unit_of_measurement=UNIT_EMPTY,
+            icon=ICON_FRAME_QUEUE_DEPTH,
+            accuracy_decimals=0,
+            device_class=DEVICE_CLASS_EMPTY,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_DROPPED_FRAMES): sensor.sensor_schema(
+            unit_of_measurement=UNIT_EMPTY,
+            icon=ICON_DROPPED_FRAMES,
+            accuracy_decimals=0,
+            device_class=DEVICE_CLASS_EMPTY,
+            state_class=STATE_CLASS_TOTAL_INCREASING,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_WAKE_TO_DATA_TIME): sensor.sensor_schema(
+            unit_of_measurement=UNIT_SECOND,
+            icon=ICON_WAKE_TO_DATA_TIME,
+            accuracy_decimals=2,
+            device_class=DEVICE_CLASS_DURATION,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_DUTY_CYCLE): sensor.sensor_schema(
+            unit_of_measurement=UNIT_PERCENT,
+            icon=ICON_DUTY_CYCLE,
+            accuracy_decimals=2,
+            device_class=DEVICE_CLASS_EMPTY,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
         cv.Optional(CONF_TEMPERATURE_1): sensor.sensor_schema(
             unit_of_measurement=UNIT_CELSIUS,
             icon=ICON_EMPTY,
@@ -600,6 +793,8 @@ CONFIG_SCHEMA = cv.Schema(
     }
 )
 
+FINAL_VALIDATE_SCHEMA = final_validate_balancing_bitmap([CONF_BALANCING_CELL_COUNT])
+
 
 async def to_code(config):
     hub = await cg.get_variable(config[CONF_BASEN_BMS_BLE_ID])
@@ -618,3 +813,10 @@ async def to_code(config):
             conf = config[key]
             sens = await sensor.new_sensor(conf)
             cg.add(getattr(hub, f"set_{key}_sensor")(sens))
+
+    frame_types = SENSORS.copy()
+    for key in TEMPERATURES:
+        frame_types[key] = [FRAME_TYPE_STATUS]
+    for i, key in enumerate(CELLS):
+        frame_types[key] = [FRAME_TYPES_CELL_VOLTAGES[i // 12]]
+    request_frames(hub, config, frame_types)
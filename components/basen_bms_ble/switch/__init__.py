@@ -3,7 +3,13 @@ from esphome.components import switch
 import esphome.config_validation as cv
 from esphome.const import CONF_ICON, CONF_ID
 
-from .. import CONF_BASEN_BMS_BLE_ID, BasenBmsBle, basen_bms_ble_ns
+from .. import (
+    CONF_BASEN_BMS_BLE_ID,
+    FRAME_TYPE_STATUS,
+    BasenBms,
+    basen_bms_ble_ns,
+    request_frames,
+)
 
 DEPENDENCIES = ["basen_bms_ble"]
 
@@ -24,7 +30,7 @@ BasenSwitch = basen_bms_ble_ns.class_("BasenSwitch", switch.Switch, cg.Component
 
 CONFIG_SCHEMA = cv.Schema(
     {
-        cv.GenerateID(CONF_BASEN_BMS_BLE_ID): cv.use_id(BasenBmsBle),
+        cv.GenerateID(CONF_BASEN_BMS_BLE_ID): cv.use_id(BasenBms),
         cv.Optional(CONF_CHARGING): switch.SWITCH_SCHEMA.extend(
             {
                 cv.GenerateID(): cv.declare_id(BasenSwitch),
@@ -52,3 +58,5 @@ async def to_code(config):
             cg.add(getattr(hub, f"set_{key}_switch")(var))
             cg.add(var.set_parent(hub))
             cg.add(var.set_holding_register(address))
+
+    request_frames(hub, config, {key: [FRAME_TYPE_STATUS] for key in SWITCHES})
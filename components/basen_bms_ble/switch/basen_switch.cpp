@@ -7,7 +7,7 @@ namespace basen_bms_ble {
 
 static const char *const TAG = "basen_bms_ble.switch";
 
-void BasenSwitch::dump_config() { LOG_SWITCH("", "BasenBmsBle Switch", this); }
+void BasenSwitch::dump_config() { LOG_SWITCH("", "BasenBms Switch", this); }
 void BasenSwitch::write_state(bool state) {
   // this->parent_->write_register(this->holding_register_, (uint16_t) state);
 }
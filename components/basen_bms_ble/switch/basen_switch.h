@@ -1,16 +1,16 @@
 #pragma once
 
-#include "../basen_bms_ble.h"
+#include "../basen_bms.h"
 #include "esphome/core/component.h"
 #include "esphome/components/switch/switch.h"
 
 namespace esphome {
 namespace basen_bms_ble {
 
-class BasenBmsBle;
+class BasenBms;
 class BasenSwitch : public switch_::Switch, public Component {
  public:
-  void set_parent(BasenBmsBle *parent) { this->parent_ = parent; };
+  void set_parent(BasenBms *parent) { this->parent_ = parent; };
   void set_holding_register(uint8_t holding_register) { this->holding_register_ = holding_register; };
   void dump_config() override;
   void loop() override {}
@@ -18,7 +18,7 @@ class BasenSwitch : public switch_::Switch, public Component {
 
  protected:
   void write_state(bool state) override;
-  BasenBmsBle *parent_;
+  BasenBms *parent_;
   uint8_t holding_register_;
 };
 
@@ -3,7 +3,15 @@ from esphome.components import text_sensor
 import esphome.config_validation as cv
 from esphome.const import CONF_ICON, CONF_ID
 
-from . import CONF_BASEN_BMS_BLE_ID, BasenBmsBle
+from . import (
+    CONF_BASEN_BMS_BLE_ID,
+    FRAME_TYPE_BALANCING,
+    FRAME_TYPE_GENERAL_INFO,
+    FRAME_TYPE_STATUS,
+    BasenBms,
+    final_validate_balancing_bitmap,
+    request_frames,
+)
 
 DEPENDENCIES = ["basen_bms_ble"]
 
@@ -14,24 +22,30 @@ CONF_DISCHARGING_STATES = "discharging_states"
 CONF_CHARGING_WARNINGS = "charging_warnings"
 CONF_DISCHARGING_WARNINGS = "discharging_warnings"
 CONF_MANUFACTURING_DATE = "manufacturing_date"
+CONF_BALANCING_CELLS = "balancing_cells"
+CONF_PROTECTION_FAULTS = "protection_faults"
 
 ICON_CHARGING_STATES = "mdi:alert-circle-outline"
 ICON_DISCHARGING_STATES = "mdi:alert-circle-outline"
 ICON_CHARGING_WARNINGS = "mdi:alert-circle-outline"
 ICON_DISCHARGING_WARNINGS = "mdi:alert-circle-outline"
 ICON_MANUFACTURING_DATE = "mdi:factory"
+ICON_BALANCING_CELLS = "mdi:battery-heart-variant"
+ICON_PROTECTION_FAULTS = "mdi:shield-alert-outline"
 
-TEXT_SENSORS = [
-    CONF_CHARGING_STATES,
-    CONF_DISCHARGING_STATES,
-    CONF_CHARGING_WARNINGS,
-    CONF_DISCHARGING_WARNINGS,
-    CONF_MANUFACTURING_DATE,
-]
+TEXT_SENSORS = {
+    CONF_CHARGING_STATES: [FRAME_TYPE_STATUS],
+    CONF_DISCHARGING_STATES: [FRAME_TYPE_STATUS],
+    CONF_CHARGING_WARNINGS: [FRAME_TYPE_STATUS],
+    CONF_DISCHARGING_WARNINGS: [FRAME_TYPE_STATUS],
+    CONF_MANUFACTURING_DATE: [FRAME_TYPE_GENERAL_INFO],
+    CONF_BALANCING_CELLS: [FRAME_TYPE_BALANCING],
+    CONF_PROTECTION_FAULTS: [FRAME_TYPE_STATUS],
+}
 
 CONFIG_SCHEMA = cv.Schema(
     {
-        cv.GenerateID(CONF_BASEN_BMS_BLE_ID): cv.use_id(BasenBmsBle),
+        cv.GenerateID(CONF_BASEN_BMS_BLE_ID): cv.use_id(BasenBms),
         cv.Optional(CONF_CHARGING_STATES): text_sensor.TEXT_SENSOR_SCHEMA.extend(
             {
                 cv.GenerateID(): cv.declare_id(text_sensor.TextSensor),
@@ -62,9 +76,23 @@ CONFIG_SCHEMA = cv.Schema(
                 cv.Optional(CONF_ICON, default=ICON_MANUFACTURING_DATE): cv.icon,
             }
         ),
+        cv.Optional(CONF_BALANCING_CELLS): text_sensor.TEXT_SENSOR_SCHEMA.extend(
+            {
+                cv.GenerateID(): cv.declare_id(text_sensor.TextSensor),
+                cv.Optional(CONF_ICON, default=ICON_BALANCING_CELLS): cv.icon,
+            }
+        ),
+        cv.Optional(CONF_PROTECTION_FAULTS): text_sensor.TEXT_SENSOR_SCHEMA.extend(
+            {
+                cv.GenerateID(): cv.declare_id(text_sensor.TextSensor),
+                cv.Optional(CONF_ICON, default=ICON_PROTECTION_FAULTS): cv.icon,
+            }
+        ),
     }
 )
 
+FINAL_VALIDATE_SCHEMA = final_validate_balancing_bitmap([CONF_BALANCING_CELLS])
+
 
 async def to_code(config):
     hub = await cg.get_variable(config[CONF_BASEN_BMS_BLE_ID])
@@ -74,3 +102,5 @@ async def to_code(config):
             sens = cg.new_Pvariable(conf[CONF_ID])
             await text_sensor.register_text_sensor(sens, conf)
             cg.add(getattr(hub, f"set_{key}_text_sensor")(sens))
+
+    request_frames(hub, config, TEXT_SENSORS)
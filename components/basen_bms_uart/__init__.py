@@ -0,0 +1,50 @@
+from esphome import pins
+import esphome.codegen as cg
+from esphome.components import uart
+from esphome.components.basen_bms_ble import (
+    BASEN_BMS_LINK_SCHEMA,
+    BasenBms,
+    register_basen_bms,
+    validate_pack_addresses,
+)
+import esphome.config_validation as cv
+from esphome.const import CONF_FLOW_CONTROL_PIN, CONF_ID
+
+CODEOWNERS = ["@syssi"]
+
+AUTO_LOAD = ["basen_bms_ble"]
+DEPENDENCIES = ["uart"]
+MULTI_CONF = True
+
+CONF_RX_TIMEOUT = "rx_timeout"
+
+basen_bms_uart_ns = cg.esphome_ns.namespace("basen_bms_uart")
+BasenBmsUart = basen_bms_uart_ns.class_("BasenBmsUart", BasenBms, uart.UARTDevice)
+
+# The entities are provided by the platforms of the basen_bms_ble component
+# and refer to this hub by "basen_bms_ble_id"
+CONFIG_SCHEMA = cv.All(
+    BASEN_BMS_LINK_SCHEMA.extend(
+        {
+            cv.GenerateID(): cv.declare_id(BasenBmsUart),
+            cv.Optional(
+                CONF_RX_TIMEOUT, default="150ms"
+            ): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_FLOW_CONTROL_PIN): pins.gpio_output_pin_schema,
+        }
+    )
+    .extend(uart.UART_DEVICE_SCHEMA)
+    .extend(cv.polling_component_schema("2s")),
+    validate_pack_addresses,
+)
+
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await register_basen_bms(var, config)
+    await uart.register_uart_device(var, config)
+
+    cg.add(var.set_rx_timeout(config[CONF_RX_TIMEOUT]))
+    if CONF_FLOW_CONTROL_PIN in config:
+        pin = await cg.gpio_pin_expression(config[CONF_FLOW_CONTROL_PIN])
+        cg.add(var.set_flow_control_pin(pin))
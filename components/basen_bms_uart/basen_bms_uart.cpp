@@ -0,0 +1,99 @@
+#include "basen_bms_uart.h"
+#include "esphome/core/log.h"
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+namespace basen_bms_uart {
+
+static const char *const TAG = "basen_bms_uart";
+
+using namespace basen_bms_ble;
+
+void BasenBmsUart::setup() {
+  if (this->flow_control_pin_ != nullptr) {
+    this->flow_control_pin_->setup();
+  }
+
+  BasenBms::setup();
+}
+
+void BasenBmsUart::loop() {
+  const uint32_t now = millis();
+  if (now - this->last_byte_ > this->rx_timeout_) {
+    this->rx_buffer_.clear();
+    this->last_byte_ = now;
+  }
+
+  while (this->available()) {
+    uint8_t byte;
+    this->read_byte(&byte);
+    if (this->parse_basen_bms_byte_(byte)) {
+      this->last_byte_ = now;
+    } else {
+      this->rx_buffer_.clear();
+    }
+  }
+
+  BasenBms::loop();
+}
+
+bool BasenBmsUart::parse_basen_bms_byte_(uint8_t byte) {
+  size_t at = this->rx_buffer_.size();
+  this->rx_buffer_.push_back(byte);
+  const uint8_t *raw = &this->rx_buffer_[0];
+
+  // Byte 0: Start of frame
+  if (at == 0)
+    return byte == BASEN_PKT_START_A || byte == BASEN_PKT_START_B;
+
+  // Byte 1: Address
+  // Byte 2: Function
+  // Byte 3: Length of the data
+  if (at < 3)
+    return true;
+
+  uint16_t frame_len = 4 + raw[3] + 4;
+  if (frame_len > MAX_RESPONSE_SIZE) {
+    ESP_LOGW(TAG, "Invalid frame length: %d", frame_len);
+    return false;
+  }
+
+  // Wait until the frame is complete
+  if (at + 1 < frame_len)
+    return true;
+
+  ESP_LOGVV(TAG, "RX <- %s", format_hex_pretty(raw, frame_len).c_str());
+
+  // The frame is validated and queued by the protocol core
+  this->assemble_(raw, frame_len);
+
+  // Reset the buffer
+  return false;
+}
+
+bool BasenBmsUart::write_frame_(const uint8_t *frame, uint16_t length) {
+  ESP_LOGVV(TAG, "TX -> %s", format_hex_pretty(frame, length).c_str());
+
+  if (this->flow_control_pin_ != nullptr) {
+    this->flow_control_pin_->digital_write(true);
+  }
+
+  this->write_array(frame, length);
+  this->flush();
+
+  if (this->flow_control_pin_ != nullptr) {
+    this->flow_control_pin_->digital_write(false);
+  }
+
+  return true;
+}
+
+void BasenBmsUart::dump_config() {
+  ESP_LOGCONFIG(TAG, "BasenBmsUart:");
+  ESP_LOGCONFIG(TAG, "  RX timeout: %d ms", this->rx_timeout_);
+  LOG_PIN("  Flow Control Pin: ", this->flow_control_pin_);
+  BasenBms::dump_config();
+}
+
+}  // namespace basen_bms_uart
+}  // namespace esphome
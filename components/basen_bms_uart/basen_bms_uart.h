@@ -0,0 +1,33 @@
+#pragma once
+
+#include "esphome/core/component.h"
+#include "esphome/core/hal.h"
+#include "esphome/components/uart/uart.h"
+#include "esphome/components/basen_bms_ble/basen_bms.h"
+
+namespace esphome {
+namespace basen_bms_uart {
+
+class BasenBmsUart : public basen_bms_ble::BasenBms, public uart::UARTDevice {
+ public:
+  void setup() override;
+  void loop() override;
+  void dump_config() override;
+
+  void set_rx_timeout(uint16_t rx_timeout) { rx_timeout_ = rx_timeout; }
+  void set_flow_control_pin(GPIOPin *flow_control_pin) { this->flow_control_pin_ = flow_control_pin; }
+
+ protected:
+  std::vector<uint8_t> rx_buffer_;
+  uint32_t last_byte_{0};
+  uint16_t rx_timeout_{150};
+  // Driver enable pin of a RS485 transceiver
+  GPIOPin *flow_control_pin_{nullptr};
+
+  bool write_frame_(const uint8_t *frame, uint16_t length) override;
+  bool is_connected_() override { return true; }
+  bool parse_basen_bms_byte_(uint8_t byte);
+};
+
+}  // namespace basen_bms_uart
+}  // namespace esphome
@@ -0,0 +1,52 @@
+import esphome.codegen as cg
+from esphome.components import web_server_base
+from esphome.components.basen_bms_ble import (
+    FRAME_TYPE_BALANCING,
+    FRAME_TYPE_GENERAL_INFO,
+    FRAME_TYPE_STATUS,
+    FRAME_TYPES_CELL_VOLTAGES,
+    BasenBms,
+)
+from esphome.components.web_server_base import CONF_WEB_SERVER_BASE_ID
+import esphome.config_validation as cv
+from esphome.const import CONF_ID
+
+CODEOWNERS = ["@syssi"]
+
+AUTO_LOAD = ["web_server_base"]
+DEPENDENCIES = ["network"]
+
+CONF_BASEN_BMS_BLE_IDS = "basen_bms_ble_ids"
+
+# Frames exported by the metrics endpoint (cells 25...34 are requested by entities only)
+METRICS_FRAME_TYPES = [
+    FRAME_TYPE_STATUS,
+    FRAME_TYPE_GENERAL_INFO,
+    *FRAME_TYPES_CELL_VOLTAGES[:2],
+    FRAME_TYPE_BALANCING,
+]
+
+basen_bms_web_ns = cg.esphome_ns.namespace("basen_bms_web")
+BasenBmsWeb = basen_bms_web_ns.class_("BasenBmsWeb", cg.Component)
+
+CONFIG_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(BasenBmsWeb),
+        cv.GenerateID(CONF_WEB_SERVER_BASE_ID): cv.use_id(
+            web_server_base.WebServerBase
+        ),
+        cv.Required(CONF_BASEN_BMS_BLE_IDS): cv.ensure_list(cv.use_id(BasenBms)),
+    }
+).extend(cv.COMPONENT_SCHEMA)
+
+
+async def to_code(config):
+    paren = await cg.get_variable(config[CONF_WEB_SERVER_BASE_ID])
+    var = cg.new_Pvariable(config[CONF_ID], paren)
+    await cg.register_component(var, config)
+
+    for pack_id in config[CONF_BASEN_BMS_BLE_IDS]:
+        pack = await cg.get_variable(pack_id)
+        cg.add(var.add_pack(pack))
+        for frame_type in METRICS_FRAME_TYPES:
+            cg.add(pack.request_frame(frame_type))
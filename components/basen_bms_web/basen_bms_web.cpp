@@ -0,0 +1,214 @@
+#include "basen_bms_web.h"
+#include "esphome/core/log.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/components/basen_bms_ble/metrics_serializer.h"
+
+#include <cstdint>
+#include <cstdlib>
+
+namespace esphome {
+namespace basen_bms_web {
+
+static const char *const TAG = "basen_bms_web";
+
+// A response is kept in RAM until it was sent, larger ranges are fetched page by page
+static const uint32_t DEFAULT_HISTORY_LIMIT = 500;
+static const uint32_t MAX_HISTORY_LIMIT = 2000;
+
+// The metrics are served from snapshots of the pack states which are at most this old
+static const uint32_t METRICS_SNAPSHOT_INTERVAL_MS = 1000;
+
+static const char *const HISTORY_CHANNELS =
+    "\"total_voltage_mv\",\"current_10ma\",\"capacity_remaining_mah\",\"state_of_charge\",\"state_masks\","
+    "\"temperature_1\",\"temperature_2\",\"temperature_3\",\"temperature_4\",\"cell_voltages_mv...\"";
+
+void BasenBmsWeb::setup() {
+  this->snapshots_.resize(this->packs_.size());
+  this->states_.resize(this->packs_.size());
+  for (size_t i = 0; i < this->packs_.size(); i++) {
+    this->snapshots_[i] = this->packs_[i]->get_state();
+    this->states_[i] = &this->snapshots_[i];
+  }
+  this->metrics_buffer_size_ = basen_bms_ble::MetricsSerializer::get_buffer_size(this->packs_.size());
+  ExternalRAMAllocator<char> allocator(ExternalRAMAllocator<char>::ALLOW_FAILURE);
+  this->metrics_buffer_ = allocator.allocate(this->metrics_buffer_size_);
+  if (this->metrics_buffer_ == nullptr) {
+    ESP_LOGE(TAG, "Could not allocate %u bytes for the metrics", (unsigned) this->metrics_buffer_size_);
+    this->metrics_buffer_size_ = 0;
+  }
+
+  this->base_->init();
+  this->base_->add_handler(this);
+}
+
+void BasenBmsWeb::loop() {
+  const uint32_t now = millis();
+  if (now - this->last_snapshot_ < METRICS_SNAPSHOT_INTERVAL_MS) {
+    return;
+  }
+
+  // Don't block the main loop while a request is serialized, retry in the next iteration
+  if (!this->metrics_lock_.try_lock()) {
+    return;
+  }
+  for (size_t i = 0; i < this->packs_.size(); i++) {
+    this->snapshots_[i] = this->packs_[i]->get_state();
+  }
+  this->metrics_lock_.unlock();
+  this->last_snapshot_ = now;
+}
+
+void BasenBmsWeb::dump_config() {
+  ESP_LOGCONFIG(TAG, "BasenBmsWeb:");
+  for (auto *pack : this->packs_) {
+    ESP_LOGCONFIG(TAG, "  Pack 0x%02X", pack->get_address());
+  }
+  ESP_LOGCONFIG(TAG, "  Metrics buffer: %u bytes", (unsigned) this->metrics_buffer_size_);
+}
+
+bool BasenBmsWeb::canHandle(AsyncWebServerRequest *request) {
+  return request->method() == HTTP_GET &&
+         (request->url() == "/basen_bms/history" || request->url() == "/basen_bms/metrics");
+}
+
+void BasenBmsWeb::handleRequest(AsyncWebServerRequest *request) {
+  if (request->url() == "/basen_bms/metrics") {
+    this->handle_metrics_(request);
+    return;
+  }
+
+  this->handle_history_(request);
+}
+
+basen_bms_ble::BasenBms *BasenBmsWeb::find_pack_(AsyncWebServerRequest *request) {
+  if (this->packs_.empty()) {
+    return nullptr;
+  }
+
+  // The first pack is the default
+  uint32_t address = this->get_param_(request, "address", this->packs_[0]->get_address());
+  for (auto *pack : this->packs_) {
+    if (pack->get_address() == address) {
+      return pack;
+    }
+  }
+
+  return nullptr;
+}
+
+uint32_t BasenBmsWeb::get_param_(AsyncWebServerRequest *request, const char *name, uint32_t fallback) {
+  if (!request->hasParam(name)) {
+    return fallback;
+  }
+
+  // Decimal or hexadecimal (0x prefix)
+  return strtoul(request->getParam(name)->value().c_str(), nullptr, 0);
+}
+
+void BasenBmsWeb::handle_history_(AsyncWebServerRequest *request) {
+  basen_bms_ble::BasenBms *pack = this->find_pack_(request);
+  if (pack == nullptr) {
+    request->send(404, "text/plain", "Unknown pack address");
+    return;
+  }
+
+  const uint32_t start = this->get_param_(request, "start", 0);
+  const uint32_t end = this->get_param_(request, "end", UINT32_MAX);
+  const uint32_t limit = std::min(this->get_param_(request, "limit", DEFAULT_HISTORY_LIMIT), MAX_HISTORY_LIMIT);
+  // Records with timestamp == start which were already sent by the previous page
+  const uint32_t skip = this->get_param_(request, "skip", 0);
+  if (limit == 0) {
+    request->send(400, "text/plain", "Limit must be at least 1");
+    return;
+  }
+
+  AsyncResponseStream *stream = nullptr;
+  size_t count = 0;
+  // The ring is appended by loop(): it is locked while the records are copied into the response
+  pack->read_history([&](const basen_bms_ble::HistoryStore &history) {
+    if (!history.is_initialized()) {
+      return;
+    }
+
+    stream = request->beginResponseStream("application/json");
+    stream->printf("{\"address\":%u,\"oldest\":%u,\"records_total\":%u,\"used_bytes\":%u,\"channels\":[%s],"
+                   "\"records\":[",
+                   pack->get_address(), (unsigned) history.get_oldest_timestamp(), (unsigned) history.get_records(),
+                   (unsigned) history.get_used(), HISTORY_CHANNELS);
+
+    uint32_t skipped = 0;
+    uint32_t last_timestamp = 0;
+    // Records of the page (and the skipped ones) with the timestamp of the last record
+    uint32_t same_timestamp = 0;
+    const size_t query_limit = skip > SIZE_MAX - limit ? SIZE_MAX : (size_t) limit + skip;
+    history.query(start, end, query_limit, [&](const basen_bms_ble::HistoryStore::Record &record) {
+      if (record.timestamp == start && skipped < skip) {
+        skipped++;
+        return;
+      }
+      if (count == limit) {
+        return;
+      }
+
+      stream->printf("%s[%u", count == 0 ? "" : ",", (unsigned) record.timestamp);
+      for (uint8_t i = 0; i < record.channels; i++) {
+        stream->printf(",%d", (int) record.values[i]);
+      }
+      stream->print("]");
+
+      if (count == 0 || record.timestamp != last_timestamp) {
+        same_timestamp = record.timestamp == start ? skipped : 0;
+      }
+      same_timestamp++;
+      last_timestamp = record.timestamp;
+      count++;
+    });
+
+    if (count == limit) {
+      stream->printf("],\"next\":{\"start\":%u,\"skip\":%u}}", (unsigned) last_timestamp, (unsigned) same_timestamp);
+    } else {
+      stream->print("],\"next\":null}");
+    }
+  });
+
+  if (stream == nullptr) {
+    request->send(404, "text/plain", "History disabled");
+    return;
+  }
+
+  ESP_LOGD(TAG, "History of pack 0x%02X: %u records sent", pack->get_address(), (unsigned) count);
+  request->send(stream);
+}
+
+void BasenBmsWeb::handle_metrics_(AsyncWebServerRequest *request) {
+  if (this->metrics_buffer_ == nullptr) {
+    request->send(500, "text/plain", "Metrics buffer not allocated");
+    return;
+  }
+
+  const bool json = request->hasParam("format") && request->getParam("format")->value() == "json";
+
+  // Held until the response owns a copy of the buffer: overlapping requests are serialized one after another
+  LockGuard guard(this->metrics_lock_);
+  basen_bms_ble::MetricsSerializer serializer(this->metrics_buffer_, this->metrics_buffer_size_);
+  if (json) {
+    serializer.write_json(this->states_.data(), this->states_.size());
+  } else {
+    serializer.write_prometheus(this->states_.data(), this->states_.size());
+  }
+
+  if (serializer.is_truncated()) {
+    ESP_LOGW(TAG, "Metrics buffer of %u bytes exceeded", (unsigned) this->metrics_buffer_size_);
+    request->send(500, "text/plain", "Metrics buffer exceeded");
+    return;
+  }
+
+  AsyncResponseStream *stream =
+      request->beginResponseStream(json ? "application/json" : "text/plain; version=0.0.4; charset=utf-8");
+  stream->print(serializer.get_buffer());
+  request->send(stream);
+}
+
+}  // namespace basen_bms_web
+}  // namespace esphome
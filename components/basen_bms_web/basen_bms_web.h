@@ -0,0 +1,56 @@
+#pragma once
+
+#include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+#include "esphome/components/web_server_base/web_server_base.h"
+#include "esphome/components/basen_bms_ble/basen_bms.h"
+
+#include <vector>
+
+namespace esphome {
+namespace basen_bms_web {
+
+// HTTP endpoints of the protocol core:
+//
+// GET /basen_bms/history?address=0x16&start=<unix time>&end=<unix time>&limit=<records>&skip=<records>
+//   Records of the compressed history, oldest first. The first `skip` records with timestamp == start are left out.
+//   If the limit was reached, "next" holds the start and skip of the following page: records sharing a timestamp
+//   are neither lost nor repeated at a page boundary.
+//
+// GET /basen_bms/metrics[?format=json]
+//   State and link metrics of all packs in one response (Prometheus text exposition format by default)
+class BasenBmsWeb : public Component, public AsyncWebHandler {
+ public:
+  BasenBmsWeb(web_server_base::WebServerBase *base) : base_(base) {}
+
+  void setup() override;
+  void loop() override;
+  void dump_config() override;
+  float get_setup_priority() const override { return setup_priority::WIFI - 1.0f; }
+
+  void add_pack(basen_bms_ble::BasenBms *pack) { this->packs_.push_back(pack); }
+
+  bool canHandle(AsyncWebServerRequest *request) override;
+  void handleRequest(AsyncWebServerRequest *request) override;
+  bool isRequestHandlerTrivial() override { return false; }
+
+ protected:
+  web_server_base::WebServerBase *base_;
+  std::vector<basen_bms_ble::BasenBms *> packs_;
+  // Copies of the pack states taken by loop(): the decoders update the states while a request is handled
+  std::vector<basen_bms_ble::PackState> snapshots_;
+  std::vector<const basen_bms_ble::PackState *> states_;
+  uint32_t last_snapshot_{0};
+  // Serialization buffer allocated once at setup, guarded together with the snapshots
+  char *metrics_buffer_{nullptr};
+  size_t metrics_buffer_size_{0};
+  Mutex metrics_lock_;
+
+  basen_bms_ble::BasenBms *find_pack_(AsyncWebServerRequest *request);
+  uint32_t get_param_(AsyncWebServerRequest *request, const char *name, uint32_t fallback);
+  void handle_history_(AsyncWebServerRequest *request);
+  void handle_metrics_(AsyncWebServerRequest *request);
+};
+
+}  // namespace basen_bms_web
+}  // namespace esphome
@@ -0,0 +1,171 @@
+// Host test of the frame assembler of the protocol core: make -C tests/host test
+#include "basen_bms_ble/basen_bms.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace esphome {
+namespace basen_bms_ble {
+
+// Transport of the test: the sent commands are recorded
+class TestLink : public BasenBms {
+ public:
+  void receive(const std::vector<uint8_t> &data, size_t fragment_size) {
+    for (size_t pos = 0; pos < data.size(); pos += fragment_size) {
+      const size_t length = data.size() - pos < fragment_size ? data.size() - pos : fragment_size;
+      this->assemble_(data.data() + pos, length);
+    }
+  }
+
+  std::vector<std::vector<uint8_t>> commands;
+
+ protected:
+  bool write_frame_(const uint8_t *frame, uint16_t length) override {
+    this->commands.emplace_back(frame, frame + length);
+    return true;
+  }
+  bool is_connected_() override { return true; }
+};
+
+}  // namespace basen_bms_ble
+}  // namespace esphome
+
+using esphome::basen_bms_ble::TestLink;
+
+static int failures = 0;
+
+#define EXPECT(condition) \
+  do { \
+    if (!(condition)) { \
+      fprintf(stderr, "%s:%d: EXPECT(%s) failed\n", __FILE__, __LINE__, #condition); \
+      failures++; \
+    } \
+  } while (0)
+
+// Cell voltages 1-12 frame of the fake traffic mode with a valid CRC
+static std::vector<uint8_t> make_cell_voltages_frame(uint16_t cell_8, uint16_t cell_9) {
+  std::vector<uint8_t> frame = {0x3a, 0x16, 0x24, 0x18, 0x96, 0x0c, 0x97, 0x0c, 0x98, 0x0c, 0x96,
+                                0x0c, 0x96, 0x0c, 0x98, 0x0c, 0x98, 0x0c, 0x97, 0x0c, 0x00, 0x00,
+                                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0d, 0x0a};
+  frame[18] = cell_8 >> 0;
+  frame[19] = cell_8 >> 8;
+  frame[20] = cell_9 >> 0;
+  frame[21] = cell_9 >> 8;
+
+  uint16_t crc = 0;
+  for (size_t i = 1; i < frame.size() - 4; i++) {
+    crc += frame[i];
+  }
+  frame[frame.size() - 4] = crc >> 0;
+  frame[frame.size() - 3] = crc >> 8;
+  return frame;
+}
+
+static TestLink *make_link(esphome::sensor::Sensor *cell_voltage_sensors) {
+  // Value initialized: the entity pointers which aren't set are nullptr
+  TestLink *link = new TestLink();
+  link->set_address(0x16);
+  for (uint8_t i = 0; i < 12; i++) {
+    link->set_cell_voltage_sensor(i, &cell_voltage_sensors[i]);
+  }
+  link->setup();
+  return link;
+}
+
+static void test_fragment_ending_in_end_of_frame_byte() {
+  // The first 20 byte notification ends with the high byte of cell 8 (2600 mV = 0x0A28)
+  esphome::sensor::Sensor sensors[12];
+  TestLink *link = make_link(sensors);
+  link->receive(make_cell_voltages_frame(2600, 3200), 20);
+  link->loop();
+
+  EXPECT(link->get_state().frames_received == 1);
+  EXPECT(link->get_state().length_errors == 0);
+  EXPECT(sensors[7].state > 2.5995f && sensors[7].state < 2.6005f);
+  delete link;
+}
+
+static void test_continuation_starting_with_preamble() {
+  // The second notification starts with the low byte of cell 9 (3130 mV = 0x0C3A)
+  esphome::sensor::Sensor sensors[12];
+  TestLink *link = make_link(sensors);
+  link->receive(make_cell_voltages_frame(3200, 3130), 20);
+  link->loop();
+
+  EXPECT(link->get_state().frames_received == 1);
+  EXPECT(sensors[8].state > 3.1295f && sensors[8].state < 3.1305f);
+  delete link;
+}
+
+static void test_orphan_fragment() {
+  esphome::sensor::Sensor sensors[12];
+  TestLink *link = make_link(sensors);
+  std::vector<uint8_t> frame = make_cell_voltages_frame(3200, 3200);
+  link->receive(std::vector<uint8_t>(frame.begin() + 20, frame.end()), 20);
+
+  EXPECT(link->get_state().frames_received == 0);
+  EXPECT(link->get_state().length_errors == 1);
+  EXPECT(link->commands.empty());
+
+  // The next frame is assembled
+  link->receive(frame, 20);
+  EXPECT(link->get_state().frames_received == 1);
+  delete link;
+}
+
+static void test_unfragmented_frames() {
+  esphome::sensor::Sensor sensors[12];
+  TestLink *link = make_link(sensors);
+  for (size_t fragment_size : {1, 7, 20, 32}) {
+    link->receive(make_cell_voltages_frame(2600, 3130), fragment_size);
+  }
+
+  EXPECT(link->get_state().frames_received == 4);
+  EXPECT(link->get_state().length_errors == 0);
+  EXPECT(link->get_state().crc_errors == 0);
+  delete link;
+}
+
+static void test_link_advances_once_per_command() {
+  esphome::sensor::Sensor sensors[12];
+  TestLink *link = make_link(sensors);
+  link->update();
+  EXPECT(link->commands.size() == 1);
+
+  // A corrupted response advances the link once, its remaining fragments don't
+  std::vector<uint8_t> corrupted = make_cell_voltages_frame(3200, 3200);
+  corrupted[corrupted.size() - 4] ^= 0xFF;
+  link->receive(corrupted, 20);
+  EXPECT(link->get_state().crc_errors == 1);
+  EXPECT(link->commands.size() == 2);
+  link->receive(std::vector<uint8_t>(corrupted.begin() + 20, corrupted.end()), 20);
+  EXPECT(link->commands.size() == 2);
+
+  // The response advances the link
+  link->receive(make_cell_voltages_frame(3200, 3200), 20);
+  EXPECT(link->commands.size() == 3);
+  delete link;
+
+  // Unsolicited frames don't
+  link = make_link(sensors);
+  link->receive(make_cell_voltages_frame(3200, 3200), 20);
+  EXPECT(link->get_state().frames_received == 1);
+  EXPECT(link->commands.empty());
+  delete link;
+}
+
+int main() {
+  test_fragment_ending_in_end_of_frame_byte();
+  test_continuation_starting_with_preamble();
+  test_orphan_fragment();
+  test_unfragmented_frames();
+  test_link_advances_once_per_command();
+
+  if (failures > 0) {
+    fprintf(stderr, "%d expectation(s) failed\n", failures);
+    return EXIT_FAILURE;
+  }
+  printf("assembler_test: all tests passed\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,125 @@
+// libFuzzer entry point of the frame assembler and the decoders of the protocol core
+//
+// Input: the first byte selects the fragmentation of the remaining bytes into notifications, the remaining bytes are
+// the received byte stream of the link:
+//   0       the stream in one notification (e.g. a frame of the UART transport)
+//   1...40  notifications of this size (e.g. 20 for the default BLE MTU)
+//   41...   random sizes seeded by the byte
+// See tests/host/Makefile for the build and the invocation.
+#include "basen_bms_ble/basen_bms.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace basen_bms_ble {
+
+// Transport of the fuzzer: all commands are discarded, the responses are the fuzz input
+class FuzzLink : public BasenBms {
+ public:
+  void receive(const uint8_t *data, uint16_t length) { this->assemble_(data, length); }
+  void decode(const std::vector<uint8_t> &data) { this->on_basen_bms_data_(data); }
+
+ protected:
+  bool write_frame_(const uint8_t *frame, uint16_t length) override { return frame != nullptr && length > 0; }
+  bool is_connected_() override { return true; }
+};
+
+}  // namespace basen_bms_ble
+}  // namespace esphome
+
+using esphome::basen_bms_ble::BasenBms;
+using esphome::basen_bms_ble::FuzzLink;
+
+static const uint8_t FRAME_TYPES[] = {0x24, 0x25, 0x26, 0x27, 0x2A, 0x2B, 0xFE};
+
+// Entities which aren't configured below stay nullptr as in a real configuration: new Fixture() zero-initializes all
+// members, the implicit constructors of the components only set the members with a default initializer
+struct Fixture {
+  FuzzLink link;
+  BasenBms pack;
+  esphome::sensor::Sensor sensors[40];
+  esphome::text_sensor::TextSensor text_sensors[7];
+  esphome::binary_sensor::BinarySensor balancing_binary_sensor;
+};
+
+static Fixture *create_fixture() {
+  Fixture *fixture = new Fixture();
+
+  // A second pack behind the link covers the demultiplexing by address
+  fixture->link.set_address(0x16);
+  fixture->pack.set_address(0x17);
+  fixture->pack.set_link(&fixture->link);
+  // Decode the experimental balancing bitmap as well
+  fixture->link.set_balancing_bitmap(true);
+
+  // Entities enable the publishing paths of the decoders
+  for (uint8_t i = 0; i < 34; i++) {
+    fixture->link.set_cell_voltage_sensor(i, &fixture->sensors[i]);
+  }
+  for (uint8_t i = 0; i < 4; i++) {
+    fixture->link.set_temperature_sensor(i, &fixture->sensors[34 + i]);
+  }
+  fixture->link.set_total_voltage_sensor(&fixture->sensors[38]);
+  fixture->link.set_delta_cell_voltage_sensor(&fixture->sensors[39]);
+  fixture->link.set_charging_states_text_sensor(&fixture->text_sensors[0]);
+  fixture->link.set_discharging_states_text_sensor(&fixture->text_sensors[1]);
+  fixture->link.set_charging_warnings_text_sensor(&fixture->text_sensors[2]);
+  fixture->link.set_discharging_warnings_text_sensor(&fixture->text_sensors[3]);
+  fixture->link.set_manufacturing_date_text_sensor(&fixture->text_sensors[4]);
+  fixture->link.set_balancing_cells_text_sensor(&fixture->text_sensors[5]);
+  fixture->link.set_protection_faults_text_sensor(&fixture->text_sensors[6]);
+  fixture->link.set_balancing_binary_sensor(&fixture->balancing_binary_sensor);
+
+  fixture->link.setup();
+  fixture->pack.setup();
+  return fixture;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  static Fixture *fixture = create_fixture();
+  if (size < 1) {
+    return 0;
+  }
+
+  const uint8_t mode = data[0];
+  const uint8_t *stream = data + 1;
+  const size_t length = size - 1;
+  uint32_t seed = mode;
+  for (size_t pos = 0; pos < length;) {
+    size_t chunk;
+    if (mode == 0) {
+      chunk = UINT16_MAX;
+    } else if (mode <= 40) {
+      chunk = mode;
+    } else {
+      // Random sizes (including empty notifications) by a linear congruential generator
+      seed = seed * 1103515245u + 12345u;
+      chunk = (seed >> 16) % 41;
+    }
+    if (chunk > length - pos) {
+      chunk = length - pos;
+    }
+    fixture->link.receive(stream + pos, chunk);
+    pos += chunk;
+  }
+
+  // Decode the frames queued by the assembler and run a poll cycle
+  fixture->link.loop();
+  fixture->pack.loop();
+  fixture->link.update();
+
+  // Every decoder with the stream as payload of a frame of consistent length, bypassing the CRC check
+  if (length <= 255) {
+    for (uint8_t start_of_frame : {0x3A, 0x3B}) {
+      for (uint8_t frame_type : FRAME_TYPES) {
+        std::vector<uint8_t> frame = {start_of_frame, 0x16, frame_type, (uint8_t) length};
+        frame.insert(frame.end(), stream, stream + length);
+        fixture->link.decode(frame);
+      }
+    }
+  }
+
+  return 0;
+}
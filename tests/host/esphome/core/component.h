@@ -0,0 +1,38 @@
+#pragma once
+
+// Minimal host shim of the ESPHome API used by the protocol core (see tests/host/esphome_shim.cpp)
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace esphome {
+
+namespace setup_priority {
+const float DATA = 600.0f;
+}  // namespace setup_priority
+
+uint32_t millis();
+
+class Component {
+ public:
+  virtual ~Component() = default;
+  virtual void setup() {}
+  virtual void loop() {}
+  virtual void dump_config() {}
+  virtual float get_setup_priority() const { return 0.0f; }
+};
+
+class PollingComponent : public Component {
+ public:
+  virtual void update() = 0;
+  virtual void set_update_interval(uint32_t update_interval) { this->update_interval_ = update_interval; }
+  virtual uint32_t get_update_interval() const { return this->update_interval_; }
+  void start_poller() {}
+  void stop_poller() {}
+
+ protected:
+  uint32_t update_interval_{0};
+};
+
+}  // namespace esphome
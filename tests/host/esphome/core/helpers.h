@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace esphome {
+
+using std::to_string;
+
+std::string format_hex_pretty(const uint8_t *data, size_t length);
+std::string format_hex_pretty(const std::vector<uint8_t> &data);
+
+template<class T> class ExternalRAMAllocator {
+ public:
+  enum Flags { NONE = 0, REFUSE_INTERNAL = 1, ALLOW_FAILURE = 4 };
+
+  ExternalRAMAllocator() = default;
+  explicit ExternalRAMAllocator(Flags flags) { (void) flags; }
+
+  T *allocate(size_t n) { return new T[n]; }
+  void deallocate(T *p, size_t n) {
+    (void) n;
+    delete[] p;
+  }
+};
+
+class Mutex {
+ public:
+  void lock() { this->mutex_.lock(); }
+  bool try_lock() { return this->mutex_.try_lock(); }
+  void unlock() { this->mutex_.unlock(); }
+
+ protected:
+  std::mutex mutex_;
+};
+
+class LockGuard {
+ public:
+  LockGuard(Mutex &mutex) : mutex_(mutex) { this->mutex_.lock(); }
+  ~LockGuard() { this->mutex_.unlock(); }
+
+ protected:
+  Mutex &mutex_;
+};
+
+template<typename... X> class CallbackManager;
+
+template<typename... Ts> class CallbackManager<void(Ts...)> {
+ public:
+  void add(std::function<void(Ts...)> &&callback) { this->callbacks_.push_back(std::move(callback)); }
+  void call(Ts... args) {
+    for (auto &callback : this->callbacks_) {
+      callback(args...);
+    }
+  }
+  size_t size() const { return this->callbacks_.size(); }
+
+ protected:
+  std::vector<std::function<void(Ts...)>> callbacks_;
+};
+
+}  // namespace esphome
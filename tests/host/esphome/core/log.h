@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdio>
+
+// The log output is discarded, the format strings are checked by the compiler
+namespace esphome {
+inline void esp_log_discard(const char *format, ...) __attribute__((format(printf, 1, 2)));
+inline void esp_log_discard(const char *format, ...) { (void) format; }
+}  // namespace esphome
+
+#define ESP_LOGE(tag, ...) esphome::esp_log_discard(__VA_ARGS__)
+#define ESP_LOGW(tag, ...) esphome::esp_log_discard(__VA_ARGS__)
+#define ESP_LOGI(tag, ...) esphome::esp_log_discard(__VA_ARGS__)
+#define ESP_LOGD(tag, ...) esphome::esp_log_discard(__VA_ARGS__)
+#define ESP_LOGV(tag, ...) esphome::esp_log_discard(__VA_ARGS__)
+#define ESP_LOGVV(tag, ...) esphome::esp_log_discard(__VA_ARGS__)
+#define ESP_LOGCONFIG(tag, ...) esphome::esp_log_discard(__VA_ARGS__)
+
+#define YESNO(b) ((b) ? "YES" : "NO")
+#define LOG_SENSOR(prefix, type, obj) (void) (obj)
+#define LOG_BINARY_SENSOR(prefix, type, obj) (void) (obj)
+#define LOG_TEXT_SENSOR(prefix, type, obj) (void) (obj)
+#define LOG_SWITCH(prefix, type, obj) (void) (obj)
+#define LOG_UPDATE_INTERVAL(obj) (void) (obj)
@@ -0,0 +1,26 @@
+#include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+
+#include <cstdio>
+
+namespace esphome {
+
+uint32_t millis() {
+  // A clock advancing by 1 ms per call keeps the timeouts and rate limits of the protocol core reachable
+  static uint32_t now = 0;
+  return now++;
+}
+
+std::string format_hex_pretty(const uint8_t *data, size_t length) {
+  std::string result;
+  char hex[4];
+  for (size_t i = 0; i < length; i++) {
+    snprintf(hex, sizeof(hex), i == 0 ? "%02X" : ".%02X", data[i]);
+    result += hex;
+  }
+  return result;
+}
+
+std::string format_hex_pretty(const std::vector<uint8_t> &data) { return format_hex_pretty(data.data(), data.size()); }
+
+}  // namespace esphome
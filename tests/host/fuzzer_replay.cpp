@@ -0,0 +1,24 @@
+// Replays inputs (e.g. the seed corpus or a crash reproducer) through the fuzz target without libFuzzer, so the
+// target can be checked with any compiler: fuzzer_replay FILE...
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+int main(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    std::ifstream file(argv[i], std::ios::binary);
+    if (!file) {
+      fprintf(stderr, "Could not open %s\n", argv[i]);
+      return 1;
+    }
+    const std::vector<uint8_t> input((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    LLVMFuzzerTestOneInput(input.data(), input.size());
+  }
+  printf("fuzzer_replay: %d input(s) replayed\n", argc - 1);
+  return 0;
+}
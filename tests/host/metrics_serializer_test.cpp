@@ -0,0 +1,244 @@
+// Host test of the metrics serializer: make -C tests/host test
+#include "basen_bms_ble/metrics_serializer.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using esphome::basen_bms_ble::MetricsSerializer;
+using esphome::basen_bms_ble::PackState;
+
+static int failures = 0;
+
+#define EXPECT(condition) \
+  do { \
+    if (!(condition)) { \
+      fprintf(stderr, "%s:%d: EXPECT(%s) failed\n", __FILE__, __LINE__, #condition); \
+      failures++; \
+    } \
+  } while (0)
+
+static bool contains(const std::string &haystack, const char *needle) {
+  return haystack.find(needle) != std::string::npos;
+}
+
+static size_t count(const std::string &haystack, const char *needle) {
+  size_t matches = 0;
+  for (size_t pos = haystack.find(needle); pos != std::string::npos; pos = haystack.find(needle, pos + 1)) {
+    matches++;
+  }
+  return matches;
+}
+
+static PackState make_pack(uint8_t address) {
+  PackState state;
+  state.address = address;
+  state.total_voltage = 53.125f;
+  state.current = -2.5f;
+  state.state_of_charge = 87.0f;
+  state.temperatures[0] = 21.0f;
+  state.temperatures[1] = 22.0f;
+  state.cell_count = 3;
+  state.cell_voltages[0] = 3301;
+  state.cell_voltages[1] = 3320;
+  state.cell_voltages[2] = 0;  // Not available
+  state.balancing_cells = 0x2;
+  state.balancing_cells_valid = true;
+  state.frames_received = 42;
+  state.crc_errors = 1;
+  return state;
+}
+
+// Every value at its widest
+static PackState make_worst_case_pack(uint8_t address) {
+  PackState state;
+  state.address = address;
+  state.total_voltage = -999.999f;
+  state.current = -9999.999f;
+  state.power = -99999.9f;
+  state.capacity_remaining = -9999.999f;
+  state.state_of_charge = 100.0f;
+  state.charging_states = 4294967295.0f;
+  state.discharging_states = 4294967295.0f;
+  state.charging_warnings = 4294967295.0f;
+  state.discharging_warnings = 4294967295.0f;
+  for (auto &temperature : state.temperatures) {
+    temperature = -128.0f;
+  }
+  state.nominal_capacity = -9999.999f;
+  state.nominal_voltage = -999.999f;
+  state.real_capacity = -9999.999f;
+  state.serial_number = 4294967295.0f;
+  state.charging_cycles = 65535.0f;
+  state.update_interval = 4294967.3f;
+  state.cell_count = PackState::MAX_CELLS;
+  for (auto &cell_voltage : state.cell_voltages) {
+    cell_voltage = 65535;
+  }
+  state.balancing_cells = ~0ull;
+  state.balancing_cells_valid = true;
+  state.frames_received = state.length_errors = state.crc_errors = state.unknown_address_frames =
+      state.dropped_frames = 4294967295u;
+  return state;
+}
+
+static void test_prometheus_single_pack() {
+  const PackState pack = make_pack(0x16);
+  const PackState *states[] = {&pack};
+  char buffer[MetricsSerializer::BUFFER_SIZE_BASE + MetricsSerializer::BUFFER_SIZE_PER_PACK];
+  MetricsSerializer serializer(buffer, sizeof(buffer));
+  serializer.write_prometheus(states, 1);
+  const std::string output(serializer.get_buffer(), serializer.get_length());
+
+  EXPECT(!serializer.is_truncated());
+  EXPECT(strlen(serializer.get_buffer()) == serializer.get_length());
+  EXPECT(contains(output, "# HELP basen_bms_total_voltage_volts Total voltage\n"));
+  EXPECT(contains(output, "# TYPE basen_bms_total_voltage_volts gauge\n"));
+  EXPECT(contains(output, "basen_bms_total_voltage_volts{address=\"0x16\"} 53.125\n"));
+  EXPECT(contains(output, "basen_bms_current_amperes{address=\"0x16\"} -2.500\n"));
+  EXPECT(contains(output, "basen_bms_state_of_charge_percent{address=\"0x16\"} 87\n"));
+  EXPECT(contains(output, "basen_bms_temperature_celsius{address=\"0x16\",sensor=\"2\"} 22\n"));
+  EXPECT(contains(output, "basen_bms_cell_voltage_volts{address=\"0x16\",cell=\"1\"} 3.301\n"));
+  EXPECT(contains(output, "basen_bms_cell_balancing{address=\"0x16\",cell=\"2\"} 1\n"));
+  EXPECT(contains(output, "basen_bms_cell_balancing{address=\"0x16\",cell=\"3\"} 0\n"));
+  EXPECT(contains(output, "# TYPE basen_bms_crc_errors_total counter\n"));
+  EXPECT(contains(output, "basen_bms_frames_received_total{address=\"0x16\"} 42\n"));
+
+  // NAN values and unavailable cells are omitted, the family header is kept
+  EXPECT(contains(output, "# TYPE basen_bms_power_watts gauge\n"));
+  EXPECT(!contains(output, "basen_bms_power_watts{"));
+  EXPECT(!contains(output, "sensor=\"3\""));
+  EXPECT(!contains(output, "basen_bms_cell_voltage_volts{address=\"0x16\",cell=\"3\"}"));
+  EXPECT(!contains(output, "nan"));
+}
+
+static void test_prometheus_multiple_packs() {
+  const PackState first = make_pack(0x16);
+  const PackState second = make_pack(0x17);
+  const PackState *states[] = {&first, &second};
+  char buffer[MetricsSerializer::BUFFER_SIZE_BASE + 2 * MetricsSerializer::BUFFER_SIZE_PER_PACK];
+  MetricsSerializer serializer(buffer, sizeof(buffer));
+  serializer.write_prometheus(states, 2);
+  const std::string output(serializer.get_buffer(), serializer.get_length());
+
+  EXPECT(!serializer.is_truncated());
+  // One HELP/TYPE header per family, followed by the samples of all packs
+  EXPECT(count(output, "# TYPE basen_bms_total_voltage_volts gauge\n") == 1);
+  EXPECT(contains(output, "basen_bms_total_voltage_volts{address=\"0x16\"} 53.125\n"
+                          "basen_bms_total_voltage_volts{address=\"0x17\"} 53.125\n"));
+  EXPECT(count(output, "basen_bms_frames_received_total{") == 2);
+}
+
+static void test_json() {
+  const PackState first = make_pack(0x16);
+  const PackState second = make_pack(0x17);
+  const PackState *states[] = {&first, &second};
+  char buffer[MetricsSerializer::BUFFER_SIZE_BASE + 2 * MetricsSerializer::BUFFER_SIZE_PER_PACK];
+  MetricsSerializer serializer(buffer, sizeof(buffer));
+
+  serializer.write_json(states, 1);
+  std::string output(serializer.get_buffer(), serializer.get_length());
+  EXPECT(!serializer.is_truncated());
+  EXPECT(output.rfind("{\"packs\":[{\"address\":22,\"total_voltage\":53.125,\"current\":-2.500,\"power\":null,", 0) ==
+         0);
+  EXPECT(contains(output, "\"temperatures\":[21,22,null,null]"));
+  EXPECT(contains(output, "\"cell_voltages\":[3301,3320,0],\"balancing_cells\":2"));
+  EXPECT(contains(output, "\"crc_errors\":1"));
+  EXPECT(output.size() >= 3 && output.compare(output.size() - 3, 3, "}]}") == 0);
+  EXPECT(!contains(output, "nan"));
+
+  serializer.reset();
+  serializer.write_json(states, 2);
+  output.assign(serializer.get_buffer(), serializer.get_length());
+  EXPECT(!serializer.is_truncated());
+  EXPECT(count(output, "{\"address\":") == 2);
+  EXPECT(contains(output, "},{\"address\":23,"));
+
+  serializer.reset();
+  serializer.write_json(states, 0);
+  EXPECT(strcmp(serializer.get_buffer(), "{\"packs\":[]}") == 0);
+}
+
+static void test_balancing_disabled() {
+  PackState pack = make_pack(0x16);
+  pack.balancing_cells_valid = false;
+  const PackState *states[] = {&pack};
+  char buffer[MetricsSerializer::BUFFER_SIZE_BASE + MetricsSerializer::BUFFER_SIZE_PER_PACK];
+  MetricsSerializer serializer(buffer, sizeof(buffer));
+
+  serializer.write_prometheus(states, 1);
+  std::string output(serializer.get_buffer(), serializer.get_length());
+  EXPECT(contains(output, "# TYPE basen_bms_cell_balancing gauge\n"));
+  EXPECT(!contains(output, "basen_bms_cell_balancing{"));
+
+  serializer.reset();
+  serializer.write_json(states, 1);
+  output.assign(serializer.get_buffer(), serializer.get_length());
+  EXPECT(contains(output, "\"balancing_cells\":null"));
+}
+
+static void test_truncation() {
+  const PackState pack = make_pack(0x16);
+  const PackState *states[] = {&pack};
+  char buffer[256];
+  memset(buffer, 'x', sizeof(buffer));
+  MetricsSerializer serializer(buffer, 200);
+  serializer.write_prometheus(states, 1);
+
+  EXPECT(serializer.is_truncated());
+  EXPECT(serializer.get_length() < 200);
+  EXPECT(strlen(serializer.get_buffer()) == serializer.get_length());
+  // Cut after the last complete line, nothing written beyond the buffer
+  EXPECT(serializer.get_length() > 0 && buffer[serializer.get_length() - 1] == '\n');
+  EXPECT(buffer[200] == 'x');
+
+  serializer.reset();
+  EXPECT(!serializer.is_truncated());
+  EXPECT(serializer.get_length() == 0);
+
+  MetricsSerializer empty(buffer, 0);
+  empty.write_json(states, 1);
+  EXPECT(empty.is_truncated());
+  EXPECT(empty.get_length() == 0);
+}
+
+static void test_worst_case_fits() {
+  static const size_t PACKS = 4;
+  std::vector<PackState> packs;
+  std::vector<const PackState *> states;
+  for (size_t i = 0; i < PACKS; i++) {
+    packs.push_back(make_worst_case_pack(0xF0 + i));
+  }
+  for (const auto &pack : packs) {
+    states.push_back(&pack);
+  }
+
+  for (size_t count = 1; count <= PACKS; count++) {
+    std::vector<char> buffer(MetricsSerializer::get_buffer_size(count));
+    MetricsSerializer serializer(buffer.data(), buffer.size());
+    serializer.write_prometheus(states.data(), count);
+    EXPECT(!serializer.is_truncated());
+
+    serializer.reset();
+    serializer.write_json(states.data(), count);
+    EXPECT(!serializer.is_truncated());
+  }
+}
+
+int main() {
+  test_prometheus_single_pack();
+  test_prometheus_multiple_packs();
+  test_json();
+  test_balancing_disabled();
+  test_truncation();
+  test_worst_case_fits();
+
+  if (failures > 0) {
+    fprintf(stderr, "%d expectation(s) failed\n", failures);
+    return EXIT_FAILURE;
+  }
+  printf("metrics_serializer_test: all tests passed\n");
+  return EXIT_SUCCESS;
+}
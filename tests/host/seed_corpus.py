@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+"""Write the seed corpus of the fuzz target from the frames of the fake traffic mode.
+
+Each input is a fragmentation mode byte (see basen_bms_fuzzer.cpp) followed by the
+received byte stream.
+"""
+
+import os
+import sys
+
+# Frames of BasenBms::inject_fake_traffic_() (address 0x16), the CRC is recomputed
+FAKE_FRAMES = {
+    "status": "3a162a1803e5ffff0664000012141919353d0000808000000e02000082050d0a",
+    "general_info": "3a162b18a08601000064000091a0010000000000307500007153070086040d0a",
+    "cell_voltages_1_12": "3a162418960c970c980c960c960c980c980c970c00000000000000006a050d0a",
+    "cell_voltages_13_24": "3a16251800000000000000000000000000000000000000000000000053000d0a",
+    "cell_voltages_25_34": "3a162614000000000000000000000000000000000000000050000d0a",
+    "balancing": "3a16fe1300f90f2c80800000800000000000000276536107050d0a",
+}
+
+
+def frame(data, start_of_frame=None, address=None):
+    """Return a frame with a valid CRC."""
+    data = bytearray(data[:-4])
+    if start_of_frame is not None:
+        data[0] = start_of_frame
+    if address is not None:
+        data[1] = address
+    crc = sum(data[1:]) & 0xFFFF
+    return bytes(data) + bytes([crc & 0xFF, crc >> 8, 0x0D, 0x0A])
+
+
+def main():
+    output = sys.argv[1] if len(sys.argv) > 1 else "corpus"
+    os.makedirs(output, exist_ok=True)
+
+    frames = {
+        name: frame(bytes.fromhex(value))
+        for name, value in FAKE_FRAMES.items()
+    }
+    # Protect IC frame with temperature 3 and 4 (start of frame 0x3B)
+    frames["protect_ic"] = frame(
+        bytes([0x3B, 0x16, 0x27, 0x13]) + bytes(range(0x10, 0x23)) + bytes(4),
+    )
+    cell_voltages = bytearray(frames["cell_voltages_1_12"])
+    cell_voltages[18:20] = (2600).to_bytes(2, "little")
+    frames["cell_voltages_0x0a_at_fragment_end"] = frame(bytes(cell_voltages))
+    # Status frame of a paralleled pack and of an unknown address
+    frames["status_pack_0x17"] = frame(frames["status"], address=0x17)
+    frames["status_unknown_address"] = frame(frames["status"], address=0x20)
+
+    inputs = {name: bytes([0]) + data for name, data in frames.items()}
+    # Frames split into 20 byte notifications (BLE) and into random sizes
+    inputs["status_fragmented"] = bytes([20]) + frames["status"]
+    inputs["balancing_fragmented"] = bytes([0xA5]) + frames["balancing"]
+    # The first notification ends in a data byte of 0x0A (cell 8 at 2600 mV)
+    inputs["cell_voltages_0x0a_at_fragment_end"] = bytes([20]) + frames[
+        "cell_voltages_0x0a_at_fragment_end"
+    ]
+
+    for name, data in inputs.items():
+        with open(os.path.join(output, name), "wb") as file:
+            file.write(data)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,536 @@
+#!/usr/bin/env python3
+"""Simulate a Basen BMS at the wired port for end-to-end tests on a Linux host.
+
+The simulator answers the request/response protocol described in
+docs/protocol-design.md over a pseudo-terminal or a TCP socket. Response
+latency, fragmentation and transmission errors are configurable and the
+reported values are generated by a simple pack model (state of charge,
+open circuit voltage, internal resistance, temperature and balancing).
+
+Usage:
+
+  # Create a pty and print its path, attach the client (e.g. basen_bms_uart) to it
+  tools/basen_bms_simulator.py --pty --latency 30 --fragment-size 20
+
+  # Serve a TCP socket instead, for example to bridge it with socat
+  tools/basen_bms_simulator.py --tcp 8888 --crc-error-rate 0.01
+
+  # Simulate two paralleled packs behind one link
+  tools/basen_bms_simulator.py --pty --address 0x16 --address 0x17
+
+The simulator measures the poll cycle latency (first request of a cycle to
+the last response) and the throughput in frames per second. A summary is
+printed every --stats-interval seconds.
+"""
+
+import argparse
+import heapq
+import os
+import random
+import select
+import socket
+import statistics
+import sys
+import time
+import tty
+
+PKT_START_A = 0x3A
+PKT_START_B = 0x3B
+PKT_END = b"\x0d\x0a"
+DEFAULT_ADDRESS = 0x16
+
+FRAME_TYPE_CELL_VOLTAGES_1_12 = 0x24
+FRAME_TYPE_CELL_VOLTAGES_13_24 = 0x25
+FRAME_TYPE_CELL_VOLTAGES_25_34 = 0x26
+FRAME_TYPE_PROTECT_IC = 0x27
+FRAME_TYPE_STATUS = 0x2A
+FRAME_TYPE_GENERAL_INFO = 0x2B
+FRAME_TYPE_SETTINGS = 0xE8
+FRAME_TYPE_SETTINGS_ALTERNATIVE = 0xEA
+FRAME_TYPE_BALANCING = 0xFE
+
+MAX_CELLS = 34
+
+# Open circuit voltage of a LiFePO4 cell (state of charge, voltage)
+OCV_CURVE = [
+    (0.00, 2.50),
+    (0.05, 3.00),
+    (0.10, 3.20),
+    (0.20, 3.25),
+    (0.40, 3.28),
+    (0.60, 3.30),
+    (0.80, 3.32),
+    (0.90, 3.35),
+    (0.95, 3.40),
+    (1.00, 3.60),
+]
+
+# Current profile of the "cycle" mode (duration in seconds, current factor)
+CYCLE_PROFILE = [(60, 0.0), (120, 1.0), (30, 0.0), (120, -1.0), (30, -0.3)]
+
+
+def chksum(data):
+    return sum(data) & 0xFFFF
+
+
+def build_frame(start_of_frame, address, frame_type, payload):
+    body = bytes([address, frame_type, len(payload)]) + bytes(payload)
+    crc = chksum(body)
+    return bytes([start_of_frame]) + body + bytes([crc & 0xFF, crc >> 8]) + PKT_END
+
+
+def ocv(soc):
+    soc = min(max(soc, 0.0), 1.0)
+    for (soc0, v0), (soc1, v1) in zip(OCV_CURVE, OCV_CURVE[1:]):
+        if soc <= soc1:
+            return v0 + (v1 - v0) * (soc - soc0) / (soc1 - soc0)
+    return OCV_CURVE[-1][1]
+
+
+class Cell:
+    def __init__(self, rng, soc, capacity):
+        self.capacity = capacity * rng.uniform(0.97, 1.03)
+        self.soc = min(max(soc + rng.uniform(-0.02, 0.02), 0.0), 1.0)
+        self.resistance = rng.uniform(0.0012, 0.0020)
+        self.balancing = False
+        self.voltage = ocv(self.soc)
+
+
+class Pack:
+    """Equivalent circuit model of a pack of serial cells."""
+
+    BALANCING_VOLTAGE = 3.40
+    BALANCING_DELTA = 0.010
+    BALANCING_CURRENT = 0.05
+    CELL_OVERVOLTAGE = 3.65
+    CELL_UNDERVOLTAGE = 2.60
+    MAX_DELTA = 0.100
+
+    def __init__(self, args, rng):
+        self.args = args
+        self.rng = rng
+        self.cells = [Cell(rng, args.soc, args.capacity) for _ in range(args.cells)]
+        self.temperature = args.ambient
+        self.current = 0.0
+        self.elapsed = 0.0
+        self.cycles = 7
+        self.charging_states = 0x80
+        self.discharging_states = 0x80
+        self.charging_warnings = 0
+        self.discharging_warnings = 0
+
+    @property
+    def soc(self):
+        return min(cell.soc for cell in self.cells)
+
+    @property
+    def total_voltage(self):
+        return sum(cell.voltage for cell in self.cells)
+
+    def requested_current(self):
+        if self.args.profile == "charge":
+            return self.args.current
+        if self.args.profile == "discharge":
+            return -self.args.current
+        if self.args.profile == "rest":
+            return 0.0
+
+        position = self.elapsed % sum(duration for duration, _ in CYCLE_PROFILE)
+        for duration, factor in CYCLE_PROFILE:
+            if position < duration:
+                return factor * self.args.current
+            position -= duration
+        return 0.0
+
+    def step(self, dt):
+        self.elapsed += dt
+        current = self.requested_current()
+        current += self.rng.gauss(0.0, 0.02 * self.args.current)
+
+        # The MOSFETs block the current if a protection tripped
+        if current > 0 and not self.charging_states & 0x80:
+            current = 0.0
+        if current < 0 and not self.discharging_states & 0x80:
+            current = 0.0
+        self.current = current
+
+        voltages = [cell.voltage for cell in self.cells]
+        min_voltage = min(voltages)
+        for cell in self.cells:
+            cell.balancing = (
+                current > 0
+                and cell.voltage > self.BALANCING_VOLTAGE
+                and cell.voltage - min_voltage > self.BALANCING_DELTA
+            )
+            cell_current = current - (self.BALANCING_CURRENT if cell.balancing else 0)
+            cell.soc += cell_current * dt / 3600.0 / cell.capacity
+            cell.soc = min(max(cell.soc, 0.0), 1.0)
+            cell.voltage = ocv(cell.soc) + current * cell.resistance
+            cell.voltage += self.rng.gauss(0.0, 0.0005)
+
+        # Joule heating of the pack and cooling to the ambient temperature
+        resistance = sum(cell.resistance for cell in self.cells)
+        heating = current * current * resistance * 0.05
+        cooling = (self.temperature - self.args.ambient) * 0.01
+        self.temperature += (heating - cooling) * dt
+
+        self.update_states()
+
+    def update_states(self):
+        voltages = [cell.voltage for cell in self.cells]
+        delta = max(voltages) - min(voltages)
+
+        self.charging_states = 0x80
+        if max(voltages) > self.CELL_OVERVOLTAGE:
+            self.charging_states = 0x08
+        if self.soc >= 1.0:
+            self.charging_states |= 0x10
+        if self.temperature > 55:
+            self.charging_states = (self.charging_states | 0x02) & 0x7F
+
+        self.discharging_states = 0x80
+        if min(voltages) < self.CELL_UNDERVOLTAGE:
+            self.discharging_states = 0x08
+        if self.soc <= 0.0:
+            self.discharging_states |= 0x10
+
+        self.charging_warnings = 0x00
+        self.discharging_warnings = 0x00
+        if delta > self.MAX_DELTA:
+            self.charging_warnings |= 0x08
+            self.discharging_warnings |= 0x08
+        if self.soc > 0.98:
+            self.charging_warnings |= 0x10
+        if self.soc < 0.10:
+            self.discharging_warnings |= 0x20
+
+    def status_payload(self):
+        payload = bytearray(24)
+        payload[0:4] = int(self.current * 1000).to_bytes(4, "little", signed=True)
+        payload[4:8] = int(self.total_voltage * 1000).to_bytes(4, "little")
+        temperature = int(round(self.temperature))
+        temperatures = [temperature, temperature - 1, temperature + 1, temperature]
+        if self.args.protect_ic_temperatures:
+            # Temperatures 3 and 4 are reported by the protect IC frame only
+            temperatures[2:4] = [-128, -128]
+        for i, value in enumerate(temperatures):
+            payload[8 + i] = value & 0xFF
+        capacity = sum(cell.capacity for cell in self.cells) / len(self.cells)
+        remaining = self.soc * capacity
+        payload[12:16] = int(remaining * 1000).to_bytes(4, "little")
+        payload[16] = self.charging_states
+        payload[17] = self.discharging_states
+        payload[18] = self.charging_warnings
+        payload[19] = self.discharging_warnings
+        payload[20] = int(round(self.soc * 100))
+        payload[21] = 0x19
+        return payload
+
+    def general_info_payload(self):
+        payload = bytearray(24)
+        payload[0:4] = int(self.args.capacity * 1000).to_bytes(4, "little")
+        payload[4:8] = int(len(self.cells) * 3200).to_bytes(4, "little")
+        real_capacity = min(cell.capacity for cell in self.cells)
+        payload[8:12] = int(real_capacity * 1000).to_bytes(4, "little")
+        payload[16:18] = (30000).to_bytes(2, "little")
+        payload[18:20] = self.args.serial_number.to_bytes(2, "little")
+        # Manufacturing date 2021.11.17
+        payload[20:22] = ((2021 - 1980) << 9 | 11 << 5 | 17).to_bytes(2, "little")
+        payload[22:24] = self.cycles.to_bytes(2, "little")
+        return payload
+
+    def cell_voltages_payload(self, chunk):
+        cells = 10 if chunk == 2 else 12
+        payload = bytearray(cells * 2)
+        for i in range(cells):
+            index = chunk * 12 + i
+            if index < len(self.cells):
+                voltage = int(round(self.cells[index].voltage * 1000))
+                payload[i * 2 : i * 2 + 2] = voltage.to_bytes(2, "little")
+        return payload
+
+    def balancing_payload(self):
+        payload = bytearray([0x01, 0x75, 0x08, 0x34]) + bytearray(15)
+        payload[4] = self.charging_states
+        payload[5] = self.discharging_states
+        payload[6] = self.charging_warnings
+        payload[7] = self.discharging_warnings
+        payload[8] = 0x80
+        bitmap = 0
+        for i, cell in enumerate(self.cells):
+            if cell.balancing:
+                bitmap |= 1 << i
+        payload[9:14] = bitmap.to_bytes(5, "little")
+        payload[15:19] = bytes([0x02, 0x76, 0x53, 0x61])
+        return payload
+
+    def protect_ic_payload(self, start_of_frame):
+        payload = bytearray(19)
+        payload[0] = self.charging_states
+        payload[1] = self.discharging_states
+        if start_of_frame == PKT_START_B:
+            temperature = int(round(self.temperature))
+            payload[9] = (temperature + 1) & 0xFF
+            payload[13] = temperature & 0xFF
+        return payload
+
+    def settings_payload(self, register):
+        # The layout of the settings frames is unknown. The register is echoed
+        # followed by a zero value to exercise the unhandled frame path
+        return bytearray([register, 0x00, 0x00])
+
+    def respond(self, start_of_frame, address, frame_type, value):
+        if frame_type == FRAME_TYPE_STATUS:
+            payload = self.status_payload()
+        elif frame_type == FRAME_TYPE_GENERAL_INFO:
+            payload = self.general_info_payload()
+        elif frame_type in (
+            FRAME_TYPE_CELL_VOLTAGES_1_12,
+            FRAME_TYPE_CELL_VOLTAGES_13_24,
+            FRAME_TYPE_CELL_VOLTAGES_25_34,
+        ):
+            chunk = frame_type - FRAME_TYPE_CELL_VOLTAGES_1_12
+            payload = self.cell_voltages_payload(chunk)
+        elif frame_type == FRAME_TYPE_PROTECT_IC:
+            payload = self.protect_ic_payload(start_of_frame)
+        elif frame_type == FRAME_TYPE_BALANCING:
+            payload = self.balancing_payload()
+        elif frame_type in (FRAME_TYPE_SETTINGS, FRAME_TYPE_SETTINGS_ALTERNATIVE):
+            payload = self.settings_payload(value)
+        else:
+            return None
+        return build_frame(start_of_frame, address, frame_type, payload)
+
+
+class Statistics:
+    def __init__(self):
+        self.requests = 0
+        self.responses = 0
+        self.invalid_requests = 0
+        self.dropped = 0
+        self.corrupted = 0
+        self.cycle_latencies = []
+        self.cycle_frames = []
+        self.cycle_start = None
+        self.cycle_end = None
+        self.cycle_count = 0
+        self.window_start = time.monotonic()
+
+    def on_request(self, now, cycle_gap):
+        self.requests += 1
+        if self.cycle_start is None or (
+            self.cycle_end is not None and now - self.cycle_end > cycle_gap
+        ):
+            self.finish_cycle()
+            self.cycle_start = now
+            self.cycle_count = 0
+
+    def on_response(self, now):
+        self.responses += 1
+        self.cycle_end = now
+        self.cycle_count += 1
+
+    def finish_cycle(self):
+        if self.cycle_start is not None and self.cycle_end is not None:
+            self.cycle_latencies.append(self.cycle_end - self.cycle_start)
+            self.cycle_frames.append(self.cycle_count)
+        self.cycle_start = None
+        self.cycle_end = None
+
+    def report(self, now):
+        elapsed = now - self.window_start
+        line = (
+            f"requests {self.requests}, responses {self.responses} "
+            f"({self.responses / elapsed:.1f} frames/s), "
+            f"invalid {self.invalid_requests}, dropped {self.dropped}, "
+            f"corrupted {self.corrupted}"
+        )
+        if self.cycle_latencies:
+            latencies = sorted(self.cycle_latencies)
+            p95 = latencies[min(len(latencies) - 1, int(len(latencies) * 0.95))]
+            line += (
+                f", cycles {len(latencies)}, cycle latency "
+                f"mean {statistics.mean(latencies) * 1000:.1f} ms "
+                f"p95 {p95 * 1000:.1f} ms, "
+                f"frames/cycle {statistics.mean(self.cycle_frames):.1f}"
+            )
+        print(line, file=sys.stderr, flush=True)
+
+        self.requests = self.responses = self.invalid_requests = 0
+        self.dropped = self.corrupted = 0
+        self.cycle_latencies = []
+        self.cycle_frames = []
+        self.window_start = now
+
+
+class Simulator:
+    def __init__(self, args):
+        self.args = args
+        self.rng = random.Random(args.seed)
+        # Paralleled packs behind the same link are told apart by the address
+        addresses = args.address or [DEFAULT_ADDRESS]
+        self.packs = {address: Pack(args, self.rng) for address in addresses}
+        self.stats = Statistics()
+        self.rx_buffer = bytearray()
+        # Pending writes (due time, sequence, data)
+        self.tx_queue = []
+        self.sequence = 0
+
+    def parse(self, data, now):
+        self.rx_buffer.extend(data)
+        while self.rx_buffer:
+            if self.rx_buffer[0] not in (PKT_START_A, PKT_START_B):
+                self.rx_buffer.pop(0)
+                continue
+            if len(self.rx_buffer) < 4:
+                return
+            frame_len = 4 + self.rx_buffer[3] + 4
+            if len(self.rx_buffer) < frame_len:
+                return
+            frame = bytes(self.rx_buffer[:frame_len])
+            del self.rx_buffer[:frame_len]
+            self.on_request(frame, now)
+
+    def on_request(self, frame, now):
+        data_len = frame[3]
+        crc = frame[4 + data_len] | frame[5 + data_len] << 8
+        if crc != chksum(frame[1 : 4 + data_len]) or frame[-2:] != PKT_END:
+            self.stats.invalid_requests += 1
+            return
+        pack = self.packs.get(frame[1])
+        if pack is None:
+            return
+
+        self.stats.on_request(now, self.args.cycle_gap / 1000.0)
+        value = frame[4] if data_len else 0
+        response = pack.respond(frame[0], frame[1], frame[2], value)
+        if response is None:
+            self.stats.invalid_requests += 1
+            return
+
+        if self.rng.random() < self.args.drop_rate:
+            self.stats.dropped += 1
+            return
+        if self.rng.random() < self.args.crc_error_rate:
+            self.stats.corrupted += 1
+            response = bytearray(response)
+            response[self.rng.randrange(4, len(response) - 4)] ^= 0xFF
+            response = bytes(response)
+
+        latency = self.args.latency + self.rng.uniform(0, self.args.jitter)
+        due = now + latency / 1000.0
+        size = self.args.fragment_size or len(response)
+        for offset in range(0, len(response), size):
+            self.enqueue(due, response[offset : offset + size])
+            due += self.args.fragment_delay / 1000.0
+        self.stats.on_response(due)
+
+    def enqueue(self, due, data):
+        self.sequence += 1
+        heapq.heappush(self.tx_queue, (due, self.sequence, data))
+
+    def run(self, fd):
+        next_step = time.monotonic()
+        next_report = next_step + self.args.stats_interval
+        while True:
+            now = time.monotonic()
+            timeout = min(next_step, next_report) - now
+            if self.tx_queue:
+                timeout = min(timeout, self.tx_queue[0][0] - now)
+            readable, _, _ = select.select([fd], [], [], max(timeout, 0))
+
+            now = time.monotonic()
+            if readable:
+                data = os.read(fd, 256)
+                if not data:
+                    return
+                self.parse(data, now)
+
+            while self.tx_queue and self.tx_queue[0][0] <= now:
+                _, _, data = heapq.heappop(self.tx_queue)
+                os.write(fd, data)
+
+            if now >= next_step:
+                for pack in self.packs.values():
+                    pack.step(self.args.step * self.args.time_scale)
+                next_step += self.args.step
+            if now >= next_report:
+                self.stats.report(now)
+                next_report += self.args.stats_interval
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    transport = parser.add_mutually_exclusive_group()
+    transport.add_argument("--pty", action="store_true", help="serve a pty (default)")
+    transport.add_argument("--tcp", type=int, metavar="PORT", help="serve a TCP port")
+    parser.add_argument(
+        "--address",
+        type=lambda x: int(x, 0),
+        action="append",
+        help="address of a simulated pack, repeat to simulate paralleled packs",
+    )
+    parser.add_argument("--latency", type=float, default=20.0, help="ms")
+    parser.add_argument("--jitter", type=float, default=0.0, help="ms")
+    parser.add_argument(
+        "--fragment-size", type=int, default=0, help="bytes, 0 disables"
+    )
+    parser.add_argument("--fragment-delay", type=float, default=2.0, help="ms")
+    parser.add_argument("--drop-rate", type=float, default=0.0)
+    parser.add_argument("--crc-error-rate", type=float, default=0.0)
+    parser.add_argument("--cells", type=int, default=8, help=f"1...{MAX_CELLS}")
+    parser.add_argument("--capacity", type=float, default=100.0, help="Ah")
+    parser.add_argument("--soc", type=float, default=0.5, help="0...1")
+    parser.add_argument("--current", type=float, default=20.0, help="A")
+    parser.add_argument(
+        "--profile",
+        choices=["cycle", "charge", "discharge", "rest"],
+        default="cycle",
+    )
+    parser.add_argument("--ambient", type=float, default=22.0, help="°C")
+    parser.add_argument(
+        "--protect-ic-temperatures",
+        action="store_true",
+        help="report temperatures 3 and 4 by the protect IC frame only",
+    )
+    parser.add_argument("--serial-number", type=int, default=0)
+    parser.add_argument("--step", type=float, default=0.1, help="physics step in s")
+    parser.add_argument("--time-scale", type=float, default=1.0)
+    parser.add_argument(
+        "--cycle-gap",
+        type=float,
+        default=500.0,
+        help="ms of silence which separates two poll cycles",
+    )
+    parser.add_argument("--stats-interval", type=float, default=10.0, help="s")
+    parser.add_argument("--seed", type=int, default=None)
+    args = parser.parse_args()
+    if not 1 <= args.cells <= MAX_CELLS:
+        parser.error(f"--cells must be between 1 and {MAX_CELLS}")
+    return args
+
+
+def main():
+    args = parse_args()
+    simulator = Simulator(args)
+
+    if args.tcp is not None:
+        server = socket.create_server(("", args.tcp))
+        print(f"Listening on port {args.tcp}", file=sys.stderr, flush=True)
+        while True:
+            connection, peer = server.accept()
+            print(f"Connection from {peer[0]}", file=sys.stderr, flush=True)
+            with connection:
+                simulator.run(connection.fileno())
+
+    master, slave = os.openpty()
+    tty.setraw(slave)
+    print(f"Serving {os.ttyname(slave)}", file=sys.stderr, flush=True)
+    simulator.run(master)
+
+
+if __name__ == "__main__":
+    try:
+        main()
+    except KeyboardInterrupt:
+        pass